@@ -31,6 +31,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/*
+ *  Vector extensions: SSE2 is part of the x86-64 base instruction set,
+ *  so there is nothing to dispatch on at runtime. Other machines use
+ *  the scalar rays.
+ */
+#if defined(__SSE2__)
+ #include <emmintrin.h>
+ #define ATTACK_VECTOR_FILES
+#endif
+
 /*
  *  Base include
  */
@@ -47,10 +57,89 @@
  |      Definitions                                                     |
  +----------------------------------------------------------------------*/
 
+/*
+ *  Mirror a change of side->attacks[to] into the attacked bitboard
+ */
+#if defined(BOARD_BITBOARDS)
+ #define MARK_ATTACKED(side, to) ((side)->attacked =\
+        ((side)->attacked & ~bit(to)) |\
+        ((unsigned long long) ((side)->attacks[to] != 0) << (to)))
+#else
+ #define MARK_ATTACKED(side, to) pass
+#endif
+
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
  +----------------------------------------------------------------------*/
 
+/*----------------------------------------------------------------------+
+ |      xor_file_rays                                                   |
+ +----------------------------------------------------------------------*/
+
+#if defined(ATTACK_VECTOR_FILES)
+
+/*
+ *  Squares are file-major, so the eight attack entries of one file are
+ *  16 contiguous bytes. Both vertical rays from a square then fit in a
+ *  single vector XOR. Only the blocker search remains a scalar loop.
+ *
+ *  Window for the lane masks: loading 8 entries at &window[8-a] gives
+ *  all lanes >= a, and at &window[16-b] all lanes < b.
+ */
+static const short window[24] = {
+        0, 0, 0, 0, 0, 0, 0, 0,
+        -1, -1, -1, -1, -1, -1, -1, -1,
+        0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+static inline
+void xor_file_rays(
+        struct board_side *side,
+        const struct board *bd,
+        int sq,
+        int dirs)
+{
+        int rank = BOARD_RANK(sq);
+        int lo = rank, hi = rank + 1; // lanes [lo, hi) excluding rank itself
+
+        if (dirs & board_attack_north) {
+                int len = data_raylen[sq][DEBRUIJN_INDEX(board_attack_north)];
+                int to = sq + BOARD_VECTOR_NORTH;
+                while (--len > 0 && bd->squares[to].piece == board_empty)
+                        to += BOARD_VECTOR_NORTH;
+                hi = BOARD_RANK(to) + 1;
+        }
+        if (dirs & board_attack_south) {
+                int len = data_raylen[sq][DEBRUIJN_INDEX(board_attack_south)];
+                int to = sq + BOARD_VECTOR_SOUTH;
+                while (--len > 0 && bd->squares[to].piece == board_empty)
+                        to += BOARD_VECTOR_SOUTH;
+                lo = BOARD_RANK(to);
+        }
+
+        short *file = &side->attacks[sq - rank];
+
+        __m128i north = _mm_and_si128(
+                _mm_loadu_si128((const __m128i *) &window[8 - (rank + 1)]),
+                _mm_loadu_si128((const __m128i *) &window[16 - hi]));
+        __m128i south = _mm_and_si128(
+                _mm_loadu_si128((const __m128i *) &window[8 - lo]),
+                _mm_loadu_si128((const __m128i *) &window[16 - rank]));
+        __m128i bits = _mm_or_si128(
+                _mm_and_si128(north, _mm_set1_epi16(board_attack_north)),
+                _mm_and_si128(south, _mm_set1_epi16(board_attack_south)));
+        _mm_storeu_si128((__m128i *) file,
+                _mm_xor_si128(_mm_loadu_si128((const __m128i *) file), bits));
+
+ #if defined(BOARD_BITBOARDS)
+        for (int r=lo; r<hi; r++) {
+                MARK_ATTACKED(side, sq - rank + r);
+        }
+ #endif
+}
+
+#endif
+
 /*----------------------------------------------------------------------+
  |      attack_xor_rays                                                 |
  +----------------------------------------------------------------------*/
@@ -91,6 +180,17 @@ void attack_xor_rays(
         assert(dirs != 0);
         assert((dirs & data_kingtab[sq]) == dirs);
 
+#if defined(ATTACK_VECTOR_FILES)
+        int vertical = dirs & (board_attack_north | board_attack_south);
+        if (vertical != 0) {
+                xor_file_rays(side, bd, sq, vertical);
+                dirs -= vertical;
+                if (dirs == 0) {
+                        return;
+                }
+        }
+#endif
+
         do {
                 dir -= dirs;
                 dir &= dirs;
@@ -109,6 +209,7 @@ void attack_xor_rays(
                         assert(BOARD_SQUARE_IS_VALID(to));
 
                         side->attacks[to] ^= dir;
+                        MARK_ATTACKED(side, to);
                         if (bd->squares[to].piece != board_empty) {
                                 break;
                         }
@@ -128,42 +229,49 @@ void attack_xor_rays(
 len_7:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_6:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_5:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_4:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_3:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_2:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
                 if (bd->squares[to].piece != board_empty) {
                         continue;
                 }
 len_1:
                 to += vector;
                 side->attacks[to] ^= dir;
+                MARK_ATTACKED(side, to);
 #endif
         } while (dirs != 0);
 }
@@ -201,6 +309,7 @@ void attack_xor_king(struct board_side *side, int sq)
                 assert(BOARD_SQUARE_IS_VALID(to));
 
                 side->attacks[to] ^= board_attack_king;
+                MARK_ATTACKED(side, to);
         } while (dirs != 0);
 }
 
@@ -239,6 +348,7 @@ void attack_add_knight(struct board_side *side, int sq)
                 assert(BOARD_SQUARE_IS_VALID(to));
 
                 side->attacks[to] += board_attack_knight;
+                MARK_ATTACKED(side, to);
         } while (dirs != 0);
 }
 
@@ -259,6 +369,7 @@ void attack_sub_knight(struct board_side *side, int sq)
                 assert(BOARD_SQUARE_IS_VALID(to));
 
                 side->attacks[to] -= board_attack_knight;
+                MARK_ATTACKED(side, to);
         } while (dirs != 0);
 }
 
@@ -274,10 +385,12 @@ void attack_xor_white_pawn(struct board_side *side, int sq)
         if (sq >= B1) {
                 side->attacks[sq + BOARD_VECTOR_NORTHWEST] ^=
                         board_attack_pawn_west;
+                MARK_ATTACKED(side, sq + BOARD_VECTOR_NORTHWEST);
         }
         if (sq <  H1) {
                 side->attacks[sq + BOARD_VECTOR_NORTHEAST] ^=
                         board_attack_pawn_east;
+                MARK_ATTACKED(side, sq + BOARD_VECTOR_NORTHEAST);
         }
 }
 
@@ -291,10 +404,12 @@ void attack_xor_black_pawn(struct board_side *side, int sq)
         if (sq >= B1) {
                 side->attacks[sq + BOARD_VECTOR_SOUTHWEST] ^=
                         board_attack_pawn_west;
+                MARK_ATTACKED(side, sq + BOARD_VECTOR_SOUTHWEST);
         }
         if (sq <  H1) {
                 side->attacks[sq + BOARD_VECTOR_SOUTHEAST] ^=
                         board_attack_pawn_east;
+                MARK_ATTACKED(side, sq + BOARD_VECTOR_SOUTHEAST);
         }
 }
 
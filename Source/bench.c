@@ -0,0 +1,482 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      bench.c -- Fixed speed benchmark for the move generator         |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Usage: bench [-o csv|json] [-r <factor>]
+ *
+ *  Runs every test on every position of a fixed suite, and reports
+ *  the node count, the wall time and the nodes per second of each.
+ *  What a node is depends on the test: one generator call, one made
+ *  move, one perft leaf or one FEN round trip. The perft counts and
+ *  the round trips are checked, so that a broken build fails loudly
+ *  instead of reporting a good speed. The repeat counts scale by
+ *  <factor> (default 1) for longer and less noisy runs.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cplus.h"
+
+#include "board.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Generator calls per position in the generation tests, and rounds
+ *  over all root moves in the make/undo and FEN tests
+ */
+#define BENCH_GENERATE_ROUNDS 50000
+#define BENCH_MAKE_ROUNDS 200000
+#define BENCH_FEN_ROUNDS 2000
+
+struct bench_position {
+        const char *name;
+        const char *fen;
+        int depth;
+        long long perft;        // expected count at depth
+        long long bulk_perft;   // expected count at depth+1
+};
+
+typedef long long bench_fn(struct board *bd, const struct bench_position *pos);
+
+struct bench_test {
+        const char *name;
+        bench_fn *fn;
+};
+
+/*----------------------------------------------------------------------+
+ |      Data                                                            |
+ +----------------------------------------------------------------------*/
+
+static const struct bench_position bench_positions[] = {
+        { "start",     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609, 119060324 },
+        { "kiwipete",  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603, 193690690 },
+        { "enpassant", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083, 178633661 },
+        { "promotion", "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", 5, 3605103, 71179139 },
+        { "castling",  "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", 5, 7594526, 179862938 },
+};
+
+static long long rounds_factor = 1;
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Recursive perft with counting at the horizon, like rmoves. That
+ *  is much faster, so the suite runs it one ply deeper.
+ */
+static
+long long perft_bulk(struct board *bd, int depth)
+{
+        if (depth <= 1)
+                return (depth == 0) ? 1 : board_count_legal_moves(bd);
+
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        long long count = 0;
+        for (int i=0; i<nr_moves; i++) {
+                board_make_move(bd, &moves[i]);
+                count += perft_bulk(bd, depth-1);
+                board_undo_move(bd);
+        }
+        return count;
+}
+
+/*
+ *  Recursive perft that makes and undoes every leaf move as well
+ */
+static
+long long perft_leaf(struct board *bd, int depth)
+{
+        if (depth == 0)
+                return 1;
+
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        long long count = 0;
+        for (int i=0; i<nr_moves; i++) {
+                board_make_move(bd, &moves[i]);
+                count += perft_leaf(bd, depth-1);
+                board_undo_move(bd);
+        }
+        return count;
+}
+
+/*
+ *  Perft through the move picker. Each node takes as hash move and
+ *  killers the first and last moves of the previous node at its
+ *  depth. These are often not legal, and the picker must skip them.
+ */
+static
+long long perft_picker(struct board *bd, int depth, unsigned short tried[][2])
+{
+        if (depth == 0)
+                return 1;
+
+        struct board_move_picker picker;
+        bd->current->killer_moves[0] = tried[depth][1];
+        bd->current->killer_moves[1] = tried[depth][0];
+        board_picker_init(&picker, bd, tried[depth][0]);
+
+        long long count = 0;
+        int first = 0, last = 0;
+        union board_move *move;
+        while ((move = board_picker_next(&picker)) != null) {
+                if (first == 0)
+                        first = move->bm.move;
+                last = move->bm.move;
+                if (depth == 1) {
+                        count++;
+                } else {
+                        board_make_move(bd, move);
+                        count += perft_picker(bd, depth-1, tried);
+                        board_undo_move(bd);
+                }
+        }
+        tried[depth][0] = first;
+        tried[depth][1] = last;
+        return count;
+}
+
+/*
+ *  Visit all nodes to the depth, and compare the cuckoo test for an
+ *  upcoming repetition in each with making every move and scanning
+ *  back for a repetition. Gives the number of nodes, or -1 if the two
+ *  differ anywhere.
+ */
+static
+long long perft_repetition(struct board *bd, int depth)
+{
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        bool upcoming = false;
+        for (int i=0; i<nr_moves && !upcoming; i++) {
+                board_make_move(bd, &moves[i]);
+                upcoming = board_check_repetition(bd);
+                board_undo_move(bd);
+        }
+        if (board_check_upcoming_repetition(bd) != upcoming)
+                return -1;
+
+        long long count = 1;
+        for (int i=0; i<nr_moves && depth>0 && count>=0; i++) {
+                board_make_move(bd, &moves[i]);
+                long long child = perft_repetition(bd, depth-1);
+                count = (child >= 0) ? count + child : -1;
+                board_undo_move(bd);
+        }
+        return count;
+}
+
+/*----------------------------------------------------------------------+
+ |      Tests                                                           |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  The generation tests run in the root and in each position after
+ *  one root move, to see a bit more variety than one position gives
+ */
+
+static
+long long bench_generate(struct board *bd, const struct bench_position *pos)
+{
+        unused(pos);
+        union board_move moves[BOARD_MAX_MOVES];
+        union board_move new_moves[BOARD_MAX_MOVES];
+        long long nodes = 0;
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+        for (int i=-1; i<nr_moves; i++) {
+                if (i >= 0)
+                        board_make_move(bd, &moves[i]);
+                for (long long r=0; r<rounds_factor*BENCH_GENERATE_ROUNDS; r++) {
+                        (void) board_generate_all_moves_unscored(bd, new_moves);
+                        nodes++;
+                }
+                if (i >= 0)
+                        board_undo_move(bd);
+        }
+        return nodes;
+}
+
+/*
+ *  The scored generator runs the static exchange evaluation for each
+ *  capture. Time only the captures, where that cost is concentrated.
+ */
+static
+long long bench_see(struct board *bd, const struct bench_position *pos)
+{
+        unused(pos);
+        union board_move moves[BOARD_MAX_MOVES];
+        union board_move new_moves[BOARD_MAX_MOVES];
+        long long nodes = 0;
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+        for (int i=-1; i<nr_moves; i++) {
+                if (i >= 0)
+                        board_make_move(bd, &moves[i]);
+                if (!board_in_check(bd)) {
+                        for (long long r=0; r<rounds_factor*BENCH_GENERATE_ROUNDS; r++) {
+                                (void) board_generate_captures_and_promotions(bd, new_moves);
+                                nodes++;
+                        }
+                }
+                if (i >= 0)
+                        board_undo_move(bd);
+        }
+        return nodes;
+}
+
+static
+long long bench_make_undo(struct board *bd, const struct bench_position *pos)
+{
+        unused(pos);
+        union board_move moves[BOARD_MAX_MOVES];
+        long long nodes = 0;
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+        for (long long r=0; r<rounds_factor*BENCH_MAKE_ROUNDS; r++) {
+                for (int i=0; i<nr_moves; i++) {
+                        board_make_move(bd, &moves[i]);
+                        board_undo_move(bd);
+                }
+                nodes += nr_moves;
+        }
+        return nodes;
+}
+
+static
+long long bench_perft_bulk(struct board *bd, const struct bench_position *pos)
+{
+        board_set_lazy_keys(bd, true);
+        long long nodes = perft_bulk(bd, pos->depth + 1);
+        board_set_lazy_keys(bd, false);
+        return (nodes == pos->bulk_perft) ? nodes : -1;
+}
+
+static
+long long bench_perft_leaf(struct board *bd, const struct bench_position *pos)
+{
+        board_set_lazy_keys(bd, true);
+        long long nodes = perft_leaf(bd, pos->depth);
+        board_set_lazy_keys(bd, false);
+        return (nodes == pos->perft) ? nodes : -1;
+}
+
+/*
+ *  The picker uses the scored generators, and it must give every
+ *  legal move once
+ */
+static
+long long bench_picker(struct board *bd, const struct bench_position *pos)
+{
+        unsigned short tried[BOARD_MAX_DEPTH][2] = { { 0 } };
+        long long nodes = perft_picker(bd, pos->depth, tried);
+        return (nodes == pos->perft) ? nodes : -1;
+}
+
+/*
+ *  Upcoming repetition detection needs the keys, and is checked
+ *  against plain repetition detection one ply later
+ */
+static
+long long bench_repetition(struct board *bd, const struct bench_position *pos)
+{
+        return perft_repetition(bd, pos->depth - 1);
+}
+
+/*
+ *  Format each position after one root move, and set it up again on
+ *  a second board. Both boards must then give the same FEN.
+ */
+static
+long long bench_fen(struct board *bd, const struct bench_position *pos)
+{
+        unused(pos);
+        union board_move moves[BOARD_MAX_MOVES];
+        struct board *copy = null;
+        long long nodes = 0;
+
+        if (board_create(&copy) != OK)
+                return -1;
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+        for (long long r=0; r<rounds_factor*BENCH_FEN_ROUNDS && nodes>=0; r++) {
+                for (int i=0; i<nr_moves; i++) {
+                        char fen[BOARD_MAX_FEN_STRING_SIZE];
+                        char copy_fen[BOARD_MAX_FEN_STRING_SIZE];
+                        board_make_move(bd, &moves[i]);
+                        (void) board_fen_string(bd, fen);
+                        board_undo_move(bd);
+                        if (board_setup_raw(copy, fen) != OK) {
+                                nodes = -1;
+                                break;
+                        }
+                        (void) board_fen_string(copy, copy_fen);
+                        if (strcmp(fen, copy_fen) != 0) {
+                                nodes = -1;
+                                break;
+                        }
+                        nodes++;
+                }
+        }
+
+        board_destroy(copy);
+        return nodes;
+}
+
+/*
+ *  Restore each position after one root move from a snapshot on a
+ *  second board, prepared for a search to the depth. The first time,
+ *  the copy must give the same FEN and keys, and pass the checks.
+ */
+static
+long long bench_snapshot(struct board *bd, const struct bench_position *pos)
+{
+        union board_move moves[BOARD_MAX_MOVES];
+        struct board_snapshot snapshots[BOARD_MAX_MOVES];
+        struct board *copy = null;
+        long long nodes = 0;
+
+        if (board_create(&copy) != OK)
+                return -1;
+        board_set_max_depth(copy, pos->depth);
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+        for (int i=0; i<nr_moves && nodes>=0; i++) {
+                char fen[BOARD_MAX_FEN_STRING_SIZE];
+                char copy_fen[BOARD_MAX_FEN_STRING_SIZE];
+                board_make_move(bd, &moves[i]);
+                board_snapshot(bd, &snapshots[i]);
+                (void) board_fen_string(bd, fen);
+                unsigned long long hash = board_hash(bd);
+                board_undo_move(bd);
+
+                if (board_restore(copy, &snapshots[i]) != OK || board_check(copy) != OK)
+                        nodes = -1;
+                (void) board_fen_string(copy, copy_fen);
+                if (strcmp(fen, copy_fen) != 0 || board_hash(copy) != hash)
+                        nodes = -1;
+        }
+
+        for (long long r=0; r<rounds_factor*BENCH_FEN_ROUNDS && nodes>=0; r++) {
+                for (int i=0; i<nr_moves; i++) {
+                        (void) board_restore(copy, &snapshots[i]);
+                        nodes++;
+                }
+        }
+
+        board_destroy(copy);
+        return nodes;
+}
+
+static const struct bench_test bench_tests[] = {
+        { "generate",   bench_generate },
+        { "see",        bench_see },
+        { "make_undo",  bench_make_undo },
+        { "perft_bulk", bench_perft_bulk },
+        { "perft_leaf", bench_perft_leaf },
+        { "picker",     bench_picker },
+        { "repetition", bench_repetition },
+        { "fen",        bench_fen },
+        { "snapshot",   bench_snapshot },
+};
+
+/*----------------------------------------------------------------------+
+ |      main                                                            |
+ +----------------------------------------------------------------------*/
+
+int main(int argc, char *argv[])
+{
+        err_t err = OK;
+        struct board *bd = null;
+        bool json = false;
+
+        int i = 1;
+        for (; i<argc && argv[i][0] == '-'; i++) {
+                if (i+1 >= argc)
+                        xRaise("Invalid arguments");
+                if (strcmp(argv[i], "-o") == 0) {
+                        i++;
+                        if (strcmp(argv[i], "json") == 0)
+                                json = true;
+                        else if (strcmp(argv[i], "csv") != 0)
+                                xRaise("Invalid output format");
+                } else if (strcmp(argv[i], "-r") == 0) {
+                        rounds_factor = atoll(argv[++i]);
+                        if (rounds_factor < 1)
+                                xRaise("Invalid repeat factor");
+                } else
+                        xRaise("Invalid arguments");
+        }
+
+        if (i != argc)
+                xRaise("Invalid arguments");
+
+        err = board_create(&bd);
+        check(err);
+
+        if (json)
+                printf("[");
+        else
+                printf("test,position,nodes,seconds,nps\n");
+
+        const char *separator = "\n";
+        for (int t=0; t<arrayLen(bench_tests); t++) {
+                for (int p=0; p<arrayLen(bench_positions); p++) {
+                        const struct bench_test *test = &bench_tests[t];
+                        const struct bench_position *pos = &bench_positions[p];
+
+                        err = board_setup_raw(bd, pos->fen);
+                        check(err);
+
+                        double start = xTime();
+                        long long nodes = test->fn(bd, pos);
+                        double seconds = xTime() - start;
+
+                        if (nodes < 0) {
+                                fprintf(stderr, "bench: %s failed for %s\n", test->name, pos->name);
+                                xRaise("Benchmark result mismatch");
+                        }
+
+                        double nps = (seconds > 0.0) ? nodes / seconds : 0.0;
+                        if (json) {
+                                printf("%s  {\"test\": \"%s\", \"position\": \"%s\", "
+                                        "\"nodes\": %lld, \"seconds\": %.6f, \"nps\": %.0f}",
+                                        separator, test->name, pos->name, nodes, seconds, nps);
+                                separator = ",\n";
+                        } else {
+                                printf("%s,%s,%lld,%.6f,%.0f\n",
+                                        test->name, pos->name, nodes, seconds, nps);
+                        }
+                        fflush(stdout);
+                }
+        }
+
+        if (json)
+                printf("\n]\n");
+
+cleanup:
+        board_destroy(bd);
+        return errExitMain(err);
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -276,6 +276,15 @@ struct board_side {
          *  Flags for pending promotions, one per file
          */
         unsigned char last_rank_pawns;
+
+#if defined(BOARD_BITBOARDS)
+        /*
+         *  Optional bitboard mirror, indexed by square. Both are copied
+         *  and restored with the rest of the side, so undo is free.
+         */
+        unsigned long long occupied;    // squares with a piece of this side
+        unsigned long long attacked;    // squares with attacks[sq] != 0
+#endif
 };
 
 #define BOARD_BISHOP_DIAGONALS(sq) (\
@@ -459,6 +468,30 @@ struct board {
          */
         int game_fullmove_number;
         int game_halfmove_clock_offset;
+
+        /*
+         *  Don't maintain hashes and material key while making moves.
+         *  Off by default. See board_set_lazy_keys().
+         */
+        bool lazy_keys;
+
+        /*
+         *  Number of moves that setup prepares the stack for, 0 for all.
+         *  See board_set_max_depth().
+         */
+        int max_depth;
+};
+
+/*
+ *  Compact copy of a position with its root frame, to hand positions
+ *  between threads. See board_snapshot().
+ */
+struct board_snapshot {
+        struct board_square squares[ BOARD_SIZE ];
+        struct board_stack_frame frame;
+        int game_fullmove_number;
+        int game_halfmove_clock_offset;
+        bool lazy_keys; // keys in frame are invalid
 };
 
 /*
@@ -470,22 +503,41 @@ struct board {
 
 /*
  *  The move generator creates board_move structs with pre-calculated SEE
- *  scores and an opaque pointer to the specific move maker code.
+ *  scores and an opaque index of the specific move maker code.
  *  The search has to add its dynamic scoring and sort the move list.
  *  The search must invoke board_make_move to perform the move, not
- *  invoke make itself.
+ *  invoke make itself. With an index instead of a pointer a move takes
+ *  8 bytes on 64-bit targets, not 16.
  */
 union board_move {
         unsigned int sort_value;
         struct {
                 short move;
                 unsigned short prescore;
-                void (*make)(void);
+                unsigned char make;
         } bm;
 };
 
 typedef union board_move board_move_t;
 
+/*
+ *  Staged move picker for search (see picker.c). The fields are
+ *  private, the struct is public so that search can keep it on its
+ *  own stack.
+ */
+struct board_move_picker {
+        struct board *bd;
+        int stage;
+        int hash_move;
+        int killer;                     // next killer_moves[] index to try
+        int next_capture;               // captures at [next_capture, nr_captures)
+        int nr_captures;
+        int next_regular;               // regular moves at [next_regular, nr_moves)
+        int nr_moves;
+        bool have_regular_moves;
+        union board_move moves[BOARD_MAX_MOVES];
+};
+
 struct board_move_info {
         uint8_t from_square;        // 0..63
         char from_piece;        // "PNBRQK"
@@ -494,6 +546,76 @@ struct board_move_info {
         char promotion_piece;   // "QRBN\0"
 };
 
+/*
+ *  Fixed-width binary position record, as a compact alternative for FEN
+ *
+ *  The occupied squares are given by a bitmap, one byte per file and
+ *  one bit per rank. Their pieces follow as 4-bit codes in square order,
+ *  low nibble first. Castling rights and en passant status are part of
+ *  the piece codes: rooks that can castle and pawns that can be captured
+ *  en passant have their own codes. As with FEN, en passant is only
+ *  encoded if a pawn is there to capture. All unused bits are zero, so
+ *  records compare equal with memcmp if and only if the positions do.
+ */
+struct board_binary {
+        uint8_t occupied[8];
+        uint8_t pieces[16];
+        uint8_t side_to_move;
+        uint8_t reserved[7];
+};
+
+#define BOARD_BINARY_SIZE 32
+
+enum board_binary_code {
+        board_binary_king,
+        board_binary_queen,
+        board_binary_rook,
+        board_binary_bishop,
+        board_binary_knight,
+        board_binary_pawn,
+        board_binary_rook_castle,
+        board_binary_pawn_en_passant,
+        board_binary_black = 8, // added for black pieces
+};
+
+/*
+ *  Counters for tuning the generator on a given position mix
+ *
+ *  They are only counted when compiled with -DBOARD_STATS, per thread.
+ *  Each generator has a scored and an unscored instantiation, counted
+ *  apart. The in-check count is of the calls made with the side to
+ *  move in check, for every generator.
+ */
+enum board_stats_generator {
+        board_stats_all_moves,
+        board_stats_all_moves_unscored,
+        board_stats_captures_and_promotions,
+        board_stats_captures_and_promotions_unscored,
+        board_stats_regular_moves,
+        board_stats_regular_moves_unscored,
+        board_stats_escapes,
+        board_stats_escapes_unscored,
+        board_stats_count_legal_moves,
+        board_stats_nr_generators
+};
+
+struct board_stats {
+        long long generate_calls[board_stats_nr_generators];
+        long long generate_moves[board_stats_nr_generators];
+        long long generate_in_check[board_stats_nr_generators];
+        long long exchange_hits;
+        long long exchange_misses;
+        long long undo_length[BOARD_UNDO_LEN_MAX + 1];
+        long long en_passant_tests;
+        long long en_passant_false_hits;     // lazily set flag had expired
+};
+
+#if defined(BOARD_STATS)
+ #define BOARD_STATS_COUNT(field, n) (board_stats.field += (n))
+#else
+ #define BOARD_STATS_COUNT(field, n) ((void) 0)
+#endif
+
 /*----------------------------------------------------------------------+
  |      Data                                                            |
  +----------------------------------------------------------------------*/
@@ -509,9 +631,14 @@ extern unsigned const short data_sq2sq[BOARD_SIZE][BOARD_SIZE];
 extern const char board_starting_position_FEN[];
 
 /*
- *  Exported for monitoring the SEE effeciency
+ *  Exported for monitoring the SEE effeciency (counted per thread)
+ */
+extern _Thread_local long long board_exchange_table_miss_counter;
+
+/*
+ *  Statistics of this thread, see BOARD_STATS_COUNT
  */
-extern long long board_exchange_table_miss_counter;
+extern _Thread_local struct board_stats board_stats;
 
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
@@ -547,12 +674,46 @@ err_t board_setup(struct board *bd,
         const char *halfmove_clock,
         const char *fullmove_number);
 
+err_t board_setup_binary(struct board *bd, const struct board_binary *record);
+
 err_t board_setup_square(
         struct board *bd,
         int square,
         int piece_char,
         int side);
 
+/*
+ *  Save the current position, and set it up again in the same or another
+ *  board without parsing or recalculating the attack tables. The moves
+ *  that led to it are not kept, so the halfmove clock restarts at the
+ *  restored position for repetition detection.
+ */
+void board_snapshot(const struct board *bd, struct board_snapshot *snapshot);
+err_t board_restore(struct board *bd, const struct board_snapshot *snapshot);
+
+/*
+ *  Position keys
+ */
+int board_en_passant_square(const struct board *bd);
+unsigned long long board_hash(const struct board *bd);
+
+/*
+ *  Lazy keys: for counting only. Hashes and material key are invalid
+ *  in positions set up or reached by making moves in lazy mode, until
+ *  board_update_keys().
+ */
+void board_set_lazy_keys(struct board *bd, bool lazy_keys);
+err_t board_update_keys(struct board *bd);
+
+/*
+ *  Let the setup functions clear only the stack frames for max_depth
+ *  moves, or all of them for 0. Clearing all takes longer than a
+ *  shallow perft, and the deeper frames aren't needed to count many
+ *  positions to a small depth. Beyond max_depth the frames keep their
+ *  node counters from before.
+ */
+void board_set_max_depth(struct board *bd, int max_depth);
+
 /*
  *  Move generator
  */
@@ -576,6 +737,27 @@ int board_generate_regular_checks(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES]);
 
+int board_count_legal_moves(struct board *bd);
+
+/*
+ *  The same generators without prescores, for tools that only enumerate
+ */
+int board_generate_all_moves_unscored(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES]);
+
+int board_generate_captures_and_promotions_unscored(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES]);
+
+int board_generate_regular_moves_unscored(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES]);
+
+int board_generate_escapes_unscored(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES]);
+
 static inline
 bool board_in_check(const struct board *bd)
 {
@@ -584,6 +766,19 @@ bool board_in_check(const struct board *bd)
 
 bool board_is_stalemate(struct board *bd);
 
+/*
+ *  Give the legal moves one by one: the hash move (or 0 for none), good
+ *  captures, the frame's killer moves, the other regular moves and bad
+ *  captures. Each group is generated only when it is needed. Gives null
+ *  after the last move. Moves stay valid until the next init.
+ */
+void board_picker_init(
+        struct board_move_picker *picker,
+        struct board *bd,
+        int hash_move);
+
+union board_move *board_picker_next(struct board_move_picker *picker);
+
 /*
  *  Make move, unmake move
  */
@@ -617,6 +812,10 @@ err_t board_fen_string(
         struct board *bd,
         char s[BOARD_MAX_FEN_STRING_SIZE]);
 
+err_t board_binary_record(
+        struct board *bd,
+        struct board_binary *record);
+
 err_t board_dump(struct board *bd); // @TODO: 2007-07-14 (marcelk) StringBuffer
 
 err_t board_format_variation(struct board *bd, char buffer[BOARD_MAX_DEPTH * BOARD_MOVE_STRING_SIZE_MAX]);
@@ -647,11 +846,31 @@ err_t board_reset_caches(void);
  */
 err_t board_reset_stats(struct board *bd);
 
+/*
+ *  Add the counters of this thread to `total', and reset them. Threads
+ *  must do this before they exit. Printing goes to stderr.
+ */
+void board_stats_add(struct board_stats *total, const struct board_stats *stats);
+void board_stats_collect(struct board_stats *total);
+void board_stats_print(const struct board_stats *stats);
+
 /*
  *  Standard performance tester
  */
 err_t board_perft(struct board *bd, int depth, long long *count_p);
 
+/*
+ *  Perft of many positions to the same depth in one call, with the
+ *  count of positions[i] in counts[i]. The board is prepared only for
+ *  that depth, which is most of the gain for small depths.
+ */
+err_t board_perft_batch(
+        struct board *bd,
+        const struct board_binary positions[],
+        int nr_positions,
+        int depth,
+        long long counts[]);
+
 /*
  *  The order (and signedness) in union board_move and signedness is
  *  'unsigned short move' + 'unsigned short prescore', such that GCC on
@@ -676,13 +895,13 @@ int board_current_ply(const struct board *bd)
 }
 
 /*
- *  Check for repetition.
+ *  Check for repetition, or for a move that repeats (see repetition.c).
+ *  Both look back no further than the halfmove clock. The upcoming
+ *  check costs one cuckoo table probe per ply there. Needs the keys.
  *  Bugs:
- *  1. This function is slow and should be replaced with something
- *     more integrated
- *  2. This function relies on hash codes, it doesn't check the
+ *  1. This function relies on hash codes, it doesn't check the
  *     actual position.
- *  3. It uses the board_hash_lazy, which doesn't contain en-passant
+ *  2. It uses the board_hash_lazy, which doesn't contain en-passant
  *     information.
  */
 bool board_check_repetition_fn(struct board *bd);
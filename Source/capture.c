@@ -135,8 +135,10 @@ void take_white_queen(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_queen][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_QUEEN;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_queen][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_QUEEN;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -152,8 +154,10 @@ void take_black_queen(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_queen][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_QUEEN;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_queen][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_QUEEN;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -215,8 +219,10 @@ void take_queen_generic(struct board *bd, int sq)
 static
 void take_white_rook(struct board *bd, int sq)
 {
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_rook][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_ROOK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_rook][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_ROOK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -242,9 +248,11 @@ void take_white_rook_castle(struct board *bd, int sq)
         }
 
         /* Note: a rook_castle uses the Zobrist keys for 'pawn' */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_rook_castle][sq];
-        bd->current->pawn_king_hash ^= data_zobrist[zobrist_white_rook_castle][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_ROOK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_rook_castle][sq];
+                bd->current->pawn_king_hash ^= data_zobrist[zobrist_white_rook_castle][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_ROOK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -257,8 +265,10 @@ void take_white_rook_castle(struct board *bd, int sq)
 static
 void take_black_rook(struct board *bd, int sq)
 {
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_rook][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_ROOK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_rook][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_ROOK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -284,9 +294,11 @@ void take_black_rook_castle(struct board *bd, int sq)
         }
 
         /* Note: a rook_castle uses the Zobrist keys for 'pawn' */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_rook_castle][sq];
-        bd->current->pawn_king_hash ^= data_zobrist[zobrist_black_rook_castle][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_ROOK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_rook_castle][sq];
+                bd->current->pawn_king_hash ^= data_zobrist[zobrist_black_rook_castle][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_ROOK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -352,8 +364,10 @@ void take_white_bishop_light(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_bishop][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_BISHOP_LIGHT;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_bishop][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_BISHOP_LIGHT;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -369,8 +383,10 @@ void take_white_bishop_dark(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_bishop][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_BISHOP_DARK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_bishop][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_BISHOP_DARK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -386,8 +402,10 @@ void take_black_bishop_light(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_bishop][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_BISHOP_LIGHT;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_bishop][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_BISHOP_LIGHT;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -404,8 +422,10 @@ void take_black_bishop_dark(struct board *bd, int sq)
          *  Update Zobrist hashes and material key
          */
 
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_bishop][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_BISHOP_DARK;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_bishop][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_BISHOP_DARK;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -471,8 +491,10 @@ void take_white_knight(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_knight][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_KNIGHT;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_knight][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_WHITE_KNIGHT;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -488,8 +510,10 @@ void take_black_knight(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_knight][sq];
-        bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_KNIGHT;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_knight][sq];
+                bd->current->material_key -= BOARD_MATERIAL_KEY_BLACK_KNIGHT;
+        }
 
         /*
          *  The rest is generic. (Tail call)
@@ -636,9 +660,11 @@ void take_white_pawn(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_pawn][sq];
-        bd->current->pawn_king_hash  ^= data_zobrist[zobrist_white_pawn][sq];
-        bd->current->material_key    -= BOARD_MATERIAL_KEY_WHITE_PAWN;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_white_pawn][sq];
+                bd->current->pawn_king_hash  ^= data_zobrist[zobrist_white_pawn][sq];
+                bd->current->material_key    -= BOARD_MATERIAL_KEY_WHITE_PAWN;
+        }
 
         /*
          *  Remove attacks
@@ -703,9 +729,11 @@ void take_black_pawn(struct board *bd, int sq)
         /*
          *  Update Zobrist hashes and material key
          */
-        bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_pawn][sq];
-        bd->current->pawn_king_hash  ^= data_zobrist[zobrist_black_pawn][sq];
-        bd->current->material_key    -= BOARD_MATERIAL_KEY_BLACK_PAWN;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= data_zobrist[zobrist_black_pawn][sq];
+                bd->current->pawn_king_hash  ^= data_zobrist[zobrist_black_pawn][sq];
+                bd->current->material_key    -= BOARD_MATERIAL_KEY_BLACK_PAWN;
+        }
 
         /*
          *  Remove attacks
@@ -770,8 +798,10 @@ void capture_with_white_king_castle(
                 delta_hash ^=
                         data_zobrist[zobrist_white_rook][A1] ^
                         data_zobrist[zobrist_white_rook_castle][A1];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][A1];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][A1];
+                }
         }
 
         if (bd->squares[H1].piece == board_white_rook_castle) {
@@ -780,8 +810,10 @@ void capture_with_white_king_castle(
                 delta_hash ^=
                         data_zobrist[zobrist_white_rook][H1] ^
                         data_zobrist[zobrist_white_rook_castle][H1];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][H1];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][H1];
+                }
         }
 
         /*
@@ -789,7 +821,9 @@ void capture_with_white_king_castle(
          */
         capture_with_king(bd, from, to);
 
-        bd->current->board_hash_lazy ^= delta_hash;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= delta_hash;
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -816,8 +850,10 @@ void capture_with_black_king_castle(
                 delta_hash ^=
                         data_zobrist[zobrist_black_rook][A8] ^
                         data_zobrist[zobrist_black_rook_castle][A8];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][A8];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][A8];
+                }
         }
 
         if (bd->squares[H8].piece == board_black_rook_castle) {
@@ -826,8 +862,10 @@ void capture_with_black_king_castle(
                 delta_hash ^=
                         data_zobrist[zobrist_black_rook][H8] ^
                         data_zobrist[zobrist_black_rook_castle][H8];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][H8];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][H8];
+                }
         }
 
         /*
@@ -835,7 +873,9 @@ void capture_with_black_king_castle(
          */
         capture_with_king(bd, from, to);
 
-        bd->current->board_hash_lazy ^= delta_hash;
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= delta_hash;
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -855,21 +895,25 @@ void capture_with_king(
          +------------------------------------------------------*/
 
         if (bd->current->active.color == board_black) {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_white_king][from] ^
-                        data_zobrist[zobrist_white_king][to];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_king][from] ^
-                        data_zobrist[zobrist_white_king][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_white_king][from] ^
+                                data_zobrist[zobrist_white_king][to];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_king][from] ^
+                                data_zobrist[zobrist_white_king][to];
+                }
         } else {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_black_king][from] ^
-                        data_zobrist[zobrist_black_king][to];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_king][from] ^
-                        data_zobrist[zobrist_black_king][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_black_king][from] ^
+                                data_zobrist[zobrist_black_king][to];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_king][from] ^
+                                data_zobrist[zobrist_black_king][to];
+                }
         }
 
         /*------------------------------------------------------+
@@ -945,15 +989,19 @@ void capture_with_queen(
          +------------------------------------------------------*/
 
         if (bd->current->active.color == board_black) {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_white_queen][from] ^
-                        data_zobrist[zobrist_white_queen][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_white_queen][from] ^
+                                data_zobrist[zobrist_white_queen][to];
+                }
         } else {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_black_queen][from] ^
-                        data_zobrist[zobrist_black_queen][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_black_queen][from] ^
+                                data_zobrist[zobrist_black_queen][to];
+                }
         }
 
         /*------------------------------------------------------+
@@ -1041,11 +1089,13 @@ void capture_with_white_rook_castle(
          */
         capture_with_rook(bd, from, to);
 
-        bd->current->board_hash_lazy ^=
-                data_zobrist[zobrist_white_rook][from] ^
-                data_zobrist[zobrist_white_rook_castle][from];
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_rook_castle][from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^=
+                        data_zobrist[zobrist_white_rook][from] ^
+                        data_zobrist[zobrist_white_rook_castle][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_rook_castle][from];
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -1078,11 +1128,13 @@ void capture_with_black_rook_castle(
          */
         capture_with_rook(bd, from, to);
 
-        bd->current->board_hash_lazy ^=
-                data_zobrist[zobrist_black_rook][from] ^
-                data_zobrist[zobrist_black_rook_castle][from];
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_rook_castle][from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^=
+                        data_zobrist[zobrist_black_rook][from] ^
+                        data_zobrist[zobrist_black_rook_castle][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_rook_castle][from];
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -1102,15 +1154,19 @@ void capture_with_rook(
          +------------------------------------------------------*/
 
         if (bd->current->active.color == board_black) {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_white_rook][from] ^
-                        data_zobrist[zobrist_white_rook][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_white_rook][from] ^
+                                data_zobrist[zobrist_white_rook][to];
+                }
         } else {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_black_rook][from] ^
-                        data_zobrist[zobrist_black_rook][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_black_rook][from] ^
+                                data_zobrist[zobrist_black_rook][to];
+                }
         }
 
         /*------------------------------------------------------+
@@ -1185,15 +1241,19 @@ void capture_with_bishop(
          +------------------------------------------------------*/
 
         if (bd->current->active.color == board_black) {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_white_bishop][from] ^
-                        data_zobrist[zobrist_white_bishop][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_white_bishop][from] ^
+                                data_zobrist[zobrist_white_bishop][to];
+                }
         } else {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_black_bishop][from] ^
-                        data_zobrist[zobrist_black_bishop][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_black_bishop][from] ^
+                                data_zobrist[zobrist_black_bishop][to];
+                }
         }
 
         /*------------------------------------------------------+
@@ -1277,15 +1337,19 @@ void capture_with_knight(
          +------------------------------------------------------*/
 
         if (bd->current->active.color == board_black) {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_white_knight][from] ^
-                        data_zobrist[zobrist_white_knight][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_white_knight][from] ^
+                                data_zobrist[zobrist_white_knight][to];
+                }
         } else {
-                bd->current->board_hash_lazy =
-                        ~bd->current[-1].board_hash_lazy ^
-                        data_zobrist[zobrist_black_knight][from] ^
-                        data_zobrist[zobrist_black_knight][to];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy =
+                                ~bd->current[-1].board_hash_lazy ^
+                                data_zobrist[zobrist_black_knight][from] ^
+                                data_zobrist[zobrist_black_knight][to];
+                }
         }
 
         /*------------------------------------------------------+
@@ -1360,14 +1424,16 @@ void capture_with_white_pawn(
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to];
+        }
 
         /*------------------------------------------------------+
          |      Remove captured piece from attack board         |
@@ -1448,14 +1514,16 @@ void capture_with_black_pawn(
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to];
+        }
 
         /*------------------------------------------------------+
          |      Remove captured piece from attack board         |
@@ -82,17 +82,19 @@ void castle_white_king_side(struct board *bd, int from, int to)
         /*
          *  Update Zobrist hashes
          */
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_king][king_from] ^
-                data_zobrist[zobrist_white_king][king_to] ^
-                data_zobrist[zobrist_white_rook_castle][rook_from] ^
-                data_zobrist[zobrist_white_rook][rook_to];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_king][king_from] ^
-                data_zobrist[zobrist_white_king][king_to] ^
-                data_zobrist[zobrist_white_rook_castle][rook_from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_king][king_from] ^
+                        data_zobrist[zobrist_white_king][king_to] ^
+                        data_zobrist[zobrist_white_rook_castle][rook_from] ^
+                        data_zobrist[zobrist_white_rook][rook_to];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_king][king_from] ^
+                        data_zobrist[zobrist_white_king][king_to] ^
+                        data_zobrist[zobrist_white_rook_castle][rook_from];
+        }
 
         /*
          *  Prepare board_unmake_move
@@ -144,11 +146,13 @@ void castle_white_king_side(struct board *bd, int from, int to)
                 PUSH_UNDO(bd->current, other_rook);
                 bd->squares[other_rook].piece = board_white_rook;
 
-                bd->current->board_hash_lazy ^=
-                        data_zobrist[zobrist_white_rook_castle][other_rook] ^
-                        data_zobrist[zobrist_white_rook][other_rook];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][other_rook];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy ^=
+                                data_zobrist[zobrist_white_rook_castle][other_rook] ^
+                                data_zobrist[zobrist_white_rook][other_rook];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][other_rook];
+                }
         }
 
         /*------------------------------------------------------+
@@ -179,17 +183,19 @@ void castle_white_queen_side(struct board *bd, int from, int to)
         /*
          *  Update Zobrist hashes
          */
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_king][king_from] ^
-                data_zobrist[zobrist_white_king][king_to] ^
-                data_zobrist[zobrist_white_rook_castle][rook_from] ^
-                data_zobrist[zobrist_white_rook][rook_to];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_king][king_from] ^
-                data_zobrist[zobrist_white_king][king_to] ^
-                data_zobrist[zobrist_white_rook_castle][rook_from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_king][king_from] ^
+                        data_zobrist[zobrist_white_king][king_to] ^
+                        data_zobrist[zobrist_white_rook_castle][rook_from] ^
+                        data_zobrist[zobrist_white_rook][rook_to];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_king][king_from] ^
+                        data_zobrist[zobrist_white_king][king_to] ^
+                        data_zobrist[zobrist_white_rook_castle][rook_from];
+        }
 
         /*
          *  Prepare board_unmake_move
@@ -241,11 +247,13 @@ void castle_white_queen_side(struct board *bd, int from, int to)
                 PUSH_UNDO(bd->current, other_rook);
                 bd->squares[other_rook].piece = board_white_rook;
 
-                bd->current->board_hash_lazy ^=
-                        data_zobrist[zobrist_white_rook_castle][other_rook] ^
-                        data_zobrist[zobrist_white_rook][other_rook];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][other_rook];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy ^=
+                                data_zobrist[zobrist_white_rook_castle][other_rook] ^
+                                data_zobrist[zobrist_white_rook][other_rook];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][other_rook];
+                }
         }
 
         /*------------------------------------------------------+
@@ -276,17 +284,19 @@ void castle_black_king_side(struct board *bd, int from, int to)
         /*
          *  Update Zobrist hashes
          */
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_king][king_from] ^
-                data_zobrist[zobrist_black_king][king_to] ^
-                data_zobrist[zobrist_black_rook_castle][rook_from] ^
-                data_zobrist[zobrist_black_rook][rook_to];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_king][king_from] ^
-                data_zobrist[zobrist_black_king][king_to] ^
-                data_zobrist[zobrist_black_rook_castle][rook_from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_king][king_from] ^
+                        data_zobrist[zobrist_black_king][king_to] ^
+                        data_zobrist[zobrist_black_rook_castle][rook_from] ^
+                        data_zobrist[zobrist_black_rook][rook_to];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_king][king_from] ^
+                        data_zobrist[zobrist_black_king][king_to] ^
+                        data_zobrist[zobrist_black_rook_castle][rook_from];
+        }
 
         /*
          *  Prepare board_unmake_move
@@ -338,11 +348,13 @@ void castle_black_king_side(struct board *bd, int from, int to)
                 PUSH_UNDO(bd->current, other_rook);
                 bd->squares[other_rook].piece = board_black_rook;
 
-                bd->current->board_hash_lazy ^=
-                        data_zobrist[zobrist_black_rook_castle][other_rook] ^
-                        data_zobrist[zobrist_black_rook][other_rook];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][other_rook];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy ^=
+                                data_zobrist[zobrist_black_rook_castle][other_rook] ^
+                                data_zobrist[zobrist_black_rook][other_rook];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][other_rook];
+                }
         }
 
         /*------------------------------------------------------+
@@ -373,17 +385,19 @@ void castle_black_queen_side(struct board *bd, int from, int to)
         /*
          *  Update Zobrist hashes
          */
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_king][king_from] ^
-                data_zobrist[zobrist_black_king][king_to] ^
-                data_zobrist[zobrist_black_rook_castle][rook_from] ^
-                data_zobrist[zobrist_black_rook][rook_to];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_king][king_from] ^
-                data_zobrist[zobrist_black_king][king_to] ^
-                data_zobrist[zobrist_black_rook_castle][rook_from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_king][king_from] ^
+                        data_zobrist[zobrist_black_king][king_to] ^
+                        data_zobrist[zobrist_black_rook_castle][rook_from] ^
+                        data_zobrist[zobrist_black_rook][rook_to];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_king][king_from] ^
+                        data_zobrist[zobrist_black_king][king_to] ^
+                        data_zobrist[zobrist_black_rook_castle][rook_from];
+        }
 
         /*
          *  Prepare board_unmake_move
@@ -435,11 +449,13 @@ void castle_black_queen_side(struct board *bd, int from, int to)
                 PUSH_UNDO(bd->current, other_rook);
                 bd->squares[other_rook].piece = board_black_rook;
 
-                bd->current->board_hash_lazy ^=
-                        data_zobrist[zobrist_black_rook_castle][other_rook] ^
-                        data_zobrist[zobrist_black_rook][other_rook];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][other_rook];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->board_hash_lazy ^=
+                                data_zobrist[zobrist_black_rook_castle][other_rook] ^
+                                data_zobrist[zobrist_black_rook][other_rook];
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][other_rook];
+                }
         }
 
         /*------------------------------------------------------+
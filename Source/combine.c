@@ -1,4 +1,6 @@
 
+#include <assert.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -6,39 +8,116 @@
 
 #include "cplus.h"
 
-int main(void)
+#include "board.h"
+#include "compress.h"
+#include "records.h"
+
+/*
+ *  Binary records don't go through `sort', so sort them here
+ */
+static
+err_t combine_binary(xInput_t input, FILE *output)
+{
+        err_t err = OK;
+        List(struct record) records = emptyList;
+        struct record record;
+
+        while (record_read_input(input, &record))
+                pushList(records, record);
+
+        qsort(records.v, records.len, sizeof(records.v[0]), record_compare);
+
+        for (int i=0; i<records.len; ) {
+                record = records.v[i];
+                for (i++; i<records.len && record_compare(&record, &records.v[i]) == 0; i++)
+                        record.count += records.v[i].count;
+                if (record.count > 0LL)
+                        record_write(output, &record);
+        }
+
+        freeList(records);
+        return err;
+}
+
+int main(int argc, char *argv[])
 {
         err_t err = OK;
-        charList lineBuffer = emptyList;
+        xInput_t input = null;
         charList lastPos = emptyList;
         long long total = 0;
+        int input_format = record_csv;
+        int compress_method = compress_none;
+        FILE *output = null;
 
-        while (readLine(stdin, &lineBuffer) != 0) {
-                long long factor = 0;
-                char *s = strchr(lineBuffer.v, ',');
-                if (s == null)
-                        s = strchr(lineBuffer.v, '\n');
-                else
-                        factor = atoll(s+1);
-                if (s != null)
-                        *s = '\0';
-
-                if (!lastPos.v || 0!=strcmp(lineBuffer.v, lastPos.v)) {
+        /*
+         *  Usage: combine [-i csv|bin] [-z none|bz2|zst|lz4]
+         *
+         *  Compressed input is recognized, -z compresses the output.
+         */
+        for (int i=1; i<argc; i+=2) {
+                if (i+1 >= argc)
+                        xRaise("Invalid arguments");
+                if (strcmp(argv[i], "-i") == 0) {
+                        err = record_parse_format(argv[i+1], &input_format);
+                        check(err);
+                } else if (strcmp(argv[i], "-z") == 0) {
+                        err = compress_parse_method(argv[i+1], &compress_method);
+                        check(err);
+                } else
+                        xRaise("Invalid arguments");
+        }
+
+        err = compress_open_input(stdin, &input);
+        check(err);
+
+        err = compress_open_output(stdout, compress_method, &output);
+        check(err);
+
+        if (input_format == record_binary) {
+                err = combine_binary(input, output);
+                check(err);
+                xReturn;
+        }
+
+        /*
+         *  Compare each line in place. Only a new key is copied, into
+         *  the buffer that the previous key leaves behind.
+         */
+        const char *line;
+        int len;
+        bool first = true;
+        while ((len = readSlice(input, &line)) != 0) {
+                long long factor;
+                int posLen = record_split_csv(line, len, &factor);
+
+                if (first || posLen != lastPos.len || memcmp(line, lastPos.v, posLen) != 0) {
                         if (total > 0LL)
-                                printf("%s,%lld\n", lastPos.v, total);
-                        freeList(lastPos);
-                        lastPos = lineBuffer;
-                        lineBuffer = (charList) emptyList;
+                                fprintf(output, "%.*s,%lld\n", lastPos.len, lastPos.v, total);
+                        lastPos.len = 0;
+                        preparePushList(lastPos, posLen + 1);
+                        memcpy(lastPos.v, line, posLen);
+                        lastPos.len = posLen;
                         total = 0;
+                        first = false;
                 }
                 total += factor;
         }
 
         if (total > 0LL)
-                printf("%s,%lld\n", lastPos.v, total);
+                fprintf(output, "%.*s,%lld\n", lastPos.len, lastPos.v, total);
 
-        freeList(lineBuffer);
+done:
+        if (output != stdout) {
+                FILE *fp = output;
+                output = null;
+                if (fclose(fp) != 0)
+                        xRaise("Write error");
+        }
+
+cleanup:
+        if (output != null && output != stdout)
+                (void) fclose(output);
+        closeInput(input);
         freeList(lastPos);
         return errExitMain(err);
 }
-
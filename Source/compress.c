@@ -0,0 +1,589 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      compress.c -- Compressed input and output for the perft tools   |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#define _GNU_SOURCE // for fopencookie
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  Compression libraries
+ */
+#include <bzlib.h>
+
+#if defined(HAVE_ZSTD)
+ #include <zstd.h>
+#endif
+
+#if defined(HAVE_LZ4)
+ #include <lz4frame.h>
+#endif
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "compress.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define COMPRESS_BUFFER_SIZE (1 << 18)
+
+/*
+ *  Level 9 is also the default of bzip2(1). zstd and lz4 use their
+ *  library defaults.
+ */
+#define COMPRESS_BZIP2_BLOCK_SIZE 9
+#define COMPRESS_ZSTD_LEVEL 3
+#define COMPRESS_LZ4_PIECE (1 << 16)
+
+struct decoder {
+        FILE *fp;
+        int method;
+        char in[COMPRESS_BUFFER_SIZE];
+        size_t in_pos;
+        size_t in_len;
+        bool raw_eof;
+        bool end;               // at the end of a stream
+        bz_stream bz;
+#if defined(HAVE_ZSTD)
+        ZSTD_DStream *zstd;
+#endif
+#if defined(HAVE_LZ4)
+        LZ4F_dctx *lz4;
+#endif
+};
+
+struct encoder {
+        FILE *fp;
+        int method;
+        char out[COMPRESS_BUFFER_SIZE];
+        bz_stream bz;
+#if defined(HAVE_ZSTD)
+        ZSTD_CStream *zstd;
+#endif
+#if defined(HAVE_LZ4)
+        LZ4F_cctx *lz4;
+#endif
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      compress_parse_method                                           |
+ +----------------------------------------------------------------------*/
+
+err_t compress_parse_method(const char *name, int *method_p)
+{
+        err_t err = OK;
+
+        if (strcmp(name, "none") == 0)
+                *method_p = compress_none;
+        else if (strcmp(name, "bz2") == 0)
+                *method_p = compress_bzip2;
+        else if (strcmp(name, "zst") == 0)
+                *method_p = compress_zstd;
+        else if (strcmp(name, "lz4") == 0)
+                *method_p = compress_lz4;
+        else
+                xRaise("Invalid compression method");
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      Decoders                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Get more compressed input when all of it is used up
+ */
+static
+void fill_input(struct decoder *dec)
+{
+        if (dec->in_pos < dec->in_len || dec->raw_eof)
+                return;
+
+        dec->in_pos = 0;
+        dec->in_len = fread(dec->in, 1, sizeof dec->in, dec->fp);
+        if (dec->in_len == 0) {
+                if (ferror(dec->fp))
+                        xAbort(errno, "fread");
+                dec->raw_eof = true;
+        }
+}
+
+static
+bool input_done(const struct decoder *dec)
+{
+        return dec->raw_eof && dec->in_pos == dec->in_len;
+}
+
+/*
+ *  Plain input that isn't a regular file, with the peeked magic first
+ */
+static
+long plain_read(void *data, char *buffer, long size)
+{
+        struct decoder *dec = data;
+
+        if (dec->in_pos < dec->in_len) {
+                long n = min(size, (long) (dec->in_len - dec->in_pos));
+                memcpy(buffer, &dec->in[dec->in_pos], n);
+                dec->in_pos += n;
+                return n;
+        }
+
+        size_t n = fread(buffer, 1, size, dec->fp);
+        if (n == 0 && ferror(dec->fp))
+                xAbort(errno, "fread");
+        return n;
+}
+
+/*
+ *  lbzip2 and `cat' give concatenated streams. Start a new
+ *  decompressor for each.
+ */
+static
+long bzip2_read(void *data, char *buffer, long size)
+{
+        struct decoder *dec = data;
+
+        dec->bz.next_out = buffer;
+        dec->bz.avail_out = size;
+
+        while (dec->bz.avail_out > 0) {
+                fill_input(dec);
+                if (dec->end) {
+                        if (input_done(dec))
+                                break;
+                        (void) BZ2_bzDecompressEnd(&dec->bz);
+                        int r = BZ2_bzDecompressInit(&dec->bz, 0, 0);
+                        if (r != BZ_OK) xAbort(ENOMEM, "BZ2_bzDecompressInit");
+                        dec->end = false;
+                }
+
+                dec->bz.next_in = &dec->in[dec->in_pos];
+                dec->bz.avail_in = dec->in_len - dec->in_pos;
+                unsigned int avail_out = dec->bz.avail_out;
+
+                int r = BZ2_bzDecompress(&dec->bz);
+                dec->in_pos = dec->in_len - dec->bz.avail_in;
+                if (r == BZ_STREAM_END)
+                        dec->end = true;
+                else if (r != BZ_OK)
+                        xAbort(EINVAL, "BZ2_bzDecompress");
+                else if (input_done(dec) && dec->bz.avail_out == avail_out)
+                        xAbort(EINVAL, "BZ2_bzDecompress"); // truncated
+        }
+
+        return size - dec->bz.avail_out;
+}
+
+/*
+ *  zstd and lz4 continue with the next frame by themselves. After the
+ *  end of a frame, they only ask for the header of the next one, so
+ *  the end stays set until new input starts another frame. Running out
+ *  of input outside that state means it was cut short.
+ */
+#if defined(HAVE_ZSTD)
+static
+long zstd_read(void *data, char *buffer, long size)
+{
+        struct decoder *dec = data;
+        ZSTD_outBuffer out = { buffer, size, 0 };
+
+        while (out.pos < out.size) {
+                fill_input(dec);
+                ZSTD_inBuffer in = { dec->in, dec->in_len, dec->in_pos };
+                size_t pos = out.pos;
+
+                size_t r = ZSTD_decompressStream(dec->zstd, &out, &in);
+                if (ZSTD_isError(r))
+                        xAbort(EINVAL, "ZSTD_decompressStream");
+                if (r == 0)
+                        dec->end = true;
+                else if (in.pos > dec->in_pos)
+                        dec->end = false;
+                dec->in_pos = in.pos;
+
+                if (input_done(dec) && out.pos == pos) {
+                        if (!dec->end)
+                                xAbort(EINVAL, "ZSTD_decompressStream"); // truncated
+                        break;
+                }
+        }
+
+        return out.pos;
+}
+#endif
+
+#if defined(HAVE_LZ4)
+static
+long lz4_read(void *data, char *buffer, long size)
+{
+        struct decoder *dec = data;
+        long pos = 0;
+
+        while (pos < size) {
+                fill_input(dec);
+                size_t dst_len = size - pos;
+                size_t src_len = dec->in_len - dec->in_pos;
+
+                size_t r = LZ4F_decompress(dec->lz4, buffer + pos, &dst_len,
+                        &dec->in[dec->in_pos], &src_len, null);
+                if (LZ4F_isError(r))
+                        xAbort(EINVAL, "LZ4F_decompress");
+                if (r == 0)
+                        dec->end = true;
+                else if (src_len > 0)
+                        dec->end = false;
+                dec->in_pos += src_len;
+                pos += dst_len;
+
+                if (input_done(dec) && dst_len == 0) {
+                        if (!dec->end)
+                                xAbort(EINVAL, "LZ4F_decompress"); // truncated
+                        break;
+                }
+        }
+
+        return pos;
+}
+#endif
+
+static
+void close_decoder(void *data)
+{
+        struct decoder *dec = data;
+
+        switch (dec->method) {
+        case compress_bzip2:
+                (void) BZ2_bzDecompressEnd(&dec->bz);
+                break;
+#if defined(HAVE_ZSTD)
+        case compress_zstd:
+                (void) ZSTD_freeDStream(dec->zstd);
+                break;
+#endif
+#if defined(HAVE_LZ4)
+        case compress_lz4:
+                (void) LZ4F_freeDecompressionContext(dec->lz4);
+                break;
+#endif
+        }
+        free(dec);
+}
+
+/*----------------------------------------------------------------------+
+ |      compress_open_input                                             |
+ +----------------------------------------------------------------------*/
+
+err_t compress_open_input(FILE *fp, xInput_t *input_p)
+{
+        err_t err = OK;
+        struct decoder *dec = null;
+
+        dec = calloc(1, sizeof(*dec));
+        if (dec == null) xRaise(ERR_NO_MEMORY);
+        dec->fp = fp;
+
+        /*
+         *  Peek at the magic. A FEN can't start with any of these.
+         */
+        long offset = ftell(fp);
+        dec->in_len = fread(dec->in, 1, 4, fp);
+        if (dec->in_len == 0 && ferror(fp))
+                xRaise("Read error");
+
+        const unsigned char *magic = (const unsigned char *) dec->in;
+        if (dec->in_len >= 4 && memcmp(magic, "BZh", 3) == 0 && magic[3] >= '1' && magic[3] <= '9')
+                dec->method = compress_bzip2;
+        else if (dec->in_len >= 4 && memcmp(magic, "\x28\xb5\x2f\xfd", 4) == 0)
+                dec->method = compress_zstd;
+        else if (dec->in_len >= 4 && memcmp(magic, "\x04\x22\x4d\x18", 4) == 0)
+                dec->method = compress_lz4;
+        else
+                dec->method = compress_none;
+
+        inputRead_fn *read = null;
+
+        switch (dec->method) {
+        case compress_none:
+                // seek back, so that regular files can still be mapped
+                if (offset >= 0 && fseek(fp, offset, SEEK_SET) == 0) {
+                        *input_p = openInput(fp);
+                        xReturn;
+                }
+                read = plain_read;
+                break;
+
+        case compress_bzip2: {
+                int r = BZ2_bzDecompressInit(&dec->bz, 0, 0);
+                if (r != BZ_OK) xRaise(ERR_NO_MEMORY);
+                read = bzip2_read;
+                break;
+        }
+
+        case compress_zstd:
+#if defined(HAVE_ZSTD)
+                dec->zstd = ZSTD_createDStream();
+                if (dec->zstd == null) xRaise(ERR_NO_MEMORY);
+                (void) ZSTD_initDStream(dec->zstd);
+                read = zstd_read;
+                break;
+#else
+                xRaise("zstd input needs a build with HAVE_ZSTD");
+#endif
+
+        case compress_lz4:
+#if defined(HAVE_LZ4)
+                if (LZ4F_isError(LZ4F_createDecompressionContext(&dec->lz4, LZ4F_VERSION)))
+                        xRaise(ERR_NO_MEMORY);
+                read = lz4_read;
+                break;
+#else
+                xRaise("lz4 input needs a build with HAVE_LZ4");
+#endif
+        }
+
+        *input_p = openReaderInput(read, close_decoder, dec);
+        dec = null;
+done:
+cleanup:
+        free(dec);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      Encoders                                                        |
+ +----------------------------------------------------------------------*/
+
+static
+bool flush_output(struct encoder *enc, size_t len)
+{
+        return fwrite(enc->out, 1, len, enc->fp) == len;
+}
+
+/*
+ *  Compress 'size' bytes, or finish the stream when buffer is null
+ */
+static
+bool encode(struct encoder *enc, const char *buffer, size_t size)
+{
+        bool finish = (buffer == null);
+
+        switch (enc->method) {
+        case compress_bzip2: {
+                enc->bz.next_in = (char *) buffer;
+                enc->bz.avail_in = size;
+                int r;
+                do {
+                        enc->bz.next_out = enc->out;
+                        enc->bz.avail_out = sizeof enc->out;
+                        r = BZ2_bzCompress(&enc->bz, finish ? BZ_FINISH : BZ_RUN);
+                        if (r != (finish ? BZ_FINISH_OK : BZ_RUN_OK) && r != BZ_STREAM_END)
+                                return false;
+                        if (!flush_output(enc, sizeof enc->out - enc->bz.avail_out))
+                                return false;
+                } while (finish ? (r != BZ_STREAM_END) : (enc->bz.avail_in > 0));
+                return true;
+        }
+
+#if defined(HAVE_ZSTD)
+        case compress_zstd: {
+                ZSTD_inBuffer in = { buffer, size, 0 };
+                size_t r;
+                do {
+                        ZSTD_outBuffer out = { enc->out, sizeof enc->out, 0 };
+                        r = finish ?
+                                ZSTD_endStream(enc->zstd, &out) :
+                                ZSTD_compressStream(enc->zstd, &out, &in);
+                        if (ZSTD_isError(r) || !flush_output(enc, out.pos))
+                                return false;
+                } while (finish ? (r != 0) : (in.pos < in.size));
+                return true;
+        }
+#endif
+
+#if defined(HAVE_LZ4)
+        case compress_lz4: {
+                size_t r;
+                if (finish) {
+                        r = LZ4F_compressEnd(enc->lz4, enc->out, sizeof enc->out, null);
+                        return !LZ4F_isError(r) && flush_output(enc, r);
+                }
+                for (size_t pos=0; pos<size; pos+=COMPRESS_LZ4_PIECE) {
+                        size_t len = min(size - pos, (size_t) COMPRESS_LZ4_PIECE);
+                        r = LZ4F_compressUpdate(enc->lz4, enc->out, sizeof enc->out,
+                                buffer + pos, len, null);
+                        if (LZ4F_isError(r) || !flush_output(enc, r))
+                                return false;
+                }
+                return true;
+        }
+#endif
+        }
+
+        return false;
+}
+
+static
+int close_encoder(struct encoder *enc)
+{
+        bool ok = encode(enc, null, 0);
+
+        switch (enc->method) {
+        case compress_bzip2:
+                (void) BZ2_bzCompressEnd(&enc->bz);
+                break;
+#if defined(HAVE_ZSTD)
+        case compress_zstd:
+                (void) ZSTD_freeCStream(enc->zstd);
+                break;
+#endif
+#if defined(HAVE_LZ4)
+        case compress_lz4:
+                (void) LZ4F_freeCompressionContext(enc->lz4);
+                break;
+#endif
+        }
+
+        if (fflush(enc->fp) != 0)
+                ok = false;
+        free(enc);
+        return ok ? 0 : EOF;
+}
+
+/*
+ *  Stream glue for glibc and for the BSDs (including OSX)
+ */
+#if defined(__GLIBC__)
+static
+ssize_t cookie_write(void *cookie, const char *buffer, size_t size)
+{
+        return encode(cookie, buffer, size) ? (ssize_t) size : -1;
+}
+
+static
+int cookie_close(void *cookie)
+{
+        return close_encoder(cookie);
+}
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+static
+int cookie_write(void *cookie, const char *buffer, int size)
+{
+        return encode(cookie, buffer, size) ? size : -1;
+}
+
+static
+int cookie_close(void *cookie)
+{
+        return close_encoder(cookie);
+}
+#endif
+
+/*----------------------------------------------------------------------+
+ |      compress_open_output                                            |
+ +----------------------------------------------------------------------*/
+
+err_t compress_open_output(FILE *fp, int method, FILE **out_p)
+{
+        err_t err = OK;
+        struct encoder *enc = null;
+
+        if (method == compress_none) {
+                *out_p = fp;
+                xReturn;
+        }
+
+        enc = calloc(1, sizeof(*enc));
+        if (enc == null) xRaise(ERR_NO_MEMORY);
+        enc->fp = fp;
+        enc->method = method;
+
+        switch (method) {
+        case compress_bzip2: {
+                int r = BZ2_bzCompressInit(&enc->bz, COMPRESS_BZIP2_BLOCK_SIZE, 0, 0);
+                if (r != BZ_OK) xRaise(ERR_NO_MEMORY);
+                break;
+        }
+
+        case compress_zstd:
+#if defined(HAVE_ZSTD)
+                enc->zstd = ZSTD_createCStream();
+                if (enc->zstd == null) xRaise(ERR_NO_MEMORY);
+                if (ZSTD_isError(ZSTD_initCStream(enc->zstd, COMPRESS_ZSTD_LEVEL)))
+                        xRaise(ERR_NO_MEMORY);
+                break;
+#else
+                xRaise("zstd output needs a build with HAVE_ZSTD");
+#endif
+
+        case compress_lz4:
+#if defined(HAVE_LZ4)
+                if (LZ4F_isError(LZ4F_createCompressionContext(&enc->lz4, LZ4F_VERSION)))
+                        xRaise(ERR_NO_MEMORY);
+                size_t r = LZ4F_compressBegin(enc->lz4, enc->out, sizeof enc->out, null);
+                if (LZ4F_isError(r) || !flush_output(enc, r))
+                        xRaise("Write error");
+                break;
+#else
+                xRaise("lz4 output needs a build with HAVE_LZ4");
+#endif
+        }
+
+        FILE *out = null;
+#if defined(__GLIBC__)
+        cookie_io_functions_t functions = {
+                .write = cookie_write,
+                .close = cookie_close,
+        };
+        out = fopencookie(enc, "w", functions);
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__) || defined(__NetBSD__)
+        out = funopen(enc, null, cookie_write, null, cookie_close);
+#endif
+        if (out == null) xRaise("Compressed output not supported on this system");
+        (void) setvbuf(out, null, _IOFBF, COMPRESS_BUFFER_SIZE);
+
+        *out_p = out;
+        enc = null;
+done:
+cleanup:
+        if (enc != null) {
+                if (enc->method == compress_bzip2)
+                        (void) BZ2_bzCompressEnd(&enc->bz);
+                free(enc);
+        }
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,66 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      compress.h -- Compressed input and output for the perft tools   |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Lets the tools read and write `ply.N.csv.*' streams without
+ *      external bzcat, lz4 or zstd processes in the pipeline.
+ *
+ *      Input is recognized by its magic bytes, so compressed and plain
+ *      input can be given on stdin alike. Decompression runs ahead on
+ *      its own thread. Concatenated streams, as made by lbzip2 and
+ *      pzstd, are read as one. Plain regular files are still mapped.
+ *
+ *      bzip2 is always available. zstd and lz4 need -DHAVE_ZSTD and
+ *      -DHAVE_LZ4 and their libraries.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include <stdio.h>
+ *  #include "cplus.h"
+ *  #include "compress.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+enum compress_method {
+        compress_none,
+        compress_bzip2,
+        compress_zstd,
+        compress_lz4,
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Method names are `none', `bz2', `zst' and `lz4', as the suffixes
+ */
+err_t compress_parse_method(const char *name, int *method_p);
+
+/*
+ *  Open fp for reading, decompressing as needed
+ */
+err_t compress_open_input(FILE *fp, xInput_t *input_p);
+
+/*
+ *  Get a stream that compresses into fp. fclose finishes the stream
+ *  and flushes fp, but leaves it open. With compress_none this is fp.
+ */
+err_t compress_open_output(FILE *fp, int method, FILE **out_p);
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
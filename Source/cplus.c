@@ -18,6 +18,7 @@
  +----------------------------------------------------------------------*/
 
 #define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE // for MAP_ANONYMOUS and syscall
 #include <assert.h>
 #include <errno.h>
 #include <math.h>
@@ -35,11 +36,17 @@
  #include <sys/timeb.h>
 #elif defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
  #include <pthread.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
  #include <sys/time.h>
  #include <unistd.h>
  #define POSIX
 #endif
 
+#if defined(__linux__)
+ #include <sys/syscall.h>
+#endif
+
 #include "cplus.h"
 
 /*----------------------------------------------------------------------+
@@ -160,6 +167,33 @@ int compareInt(const void *ap, const void *bp)
         return 0;
 }
 
+/*----------------------------------------------------------------------+
+ |      parseSize                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Parse a memory size. Plain numbers are megabytes.
+ */
+err_t parseSize(const char *s, long long *size_p)
+{
+        err_t err = OK;
+        char *end;
+
+        long long size = strtoll(s, &end, 10);
+        switch (*end) {
+        case 'K': case 'k': size <<= 10; end++; break;
+        case '\0':
+        case 'M': case 'm': size <<= 20; if (*end) end++; break;
+        case 'G': case 'g': size <<= 30; end++; break;
+        }
+        if (end == s || *end != '\0' || size < 0)
+                xRaise("Invalid size");
+
+        *size_p = size;
+cleanup:
+        return err;
+}
+
 /*----------------------------------------------------------------------+
  |      readLine                                                        |
  +----------------------------------------------------------------------*/
@@ -193,6 +227,490 @@ uint64_t xorshift64star(uint64_t x)
         return x * 2685821657736338717ULL;
 }
 
+/*----------------------------------------------------------------------+
+ |      parseLongLong                                                   |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Like atoll, but bounded by 'end' instead of a terminating zero
+ */
+long long parseLongLong(const char *s, const char *end)
+{
+        while (s < end && (*s == ' ' || *s == '\t'))
+                s++;
+
+        bool negative = false;
+        if (s < end && (*s == '-' || *s == '+'))
+                negative = (*s++ == '-');
+
+        unsigned long long n = 0;
+        for (; s < end && *s >= '0' && *s <= '9'; s++)
+                n = 10 * n + (*s - '0');
+
+        return negative ? -(long long) n : (long long) n;
+}
+
+/*----------------------------------------------------------------------+
+ |      Input streams                                                   |
+ +----------------------------------------------------------------------*/
+
+#define inputChunkSize (1 << 20)
+
+/*
+ *  Read-ahead for reader functions: the thread fills one slot while
+ *  the caller parses the other. Each slot has room in front of its data
+ *  for the unread tail of the previous slot.
+ */
+struct inputSlot {
+        char *v;
+        int headroom;
+        int len;
+        bool full;
+};
+
+struct inputAhead {
+        struct inputSlot slots[2];
+        int reading;    // slot being parsed, or -1
+        bool stop;
+#if defined(POSIX)
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        xThread_t thread;
+#endif
+};
+
+struct inputHandle {
+        FILE *fp;
+        inputRead_fn *read;
+        inputClose_fn *close;
+        void *data;     // for read and close
+        struct inputAhead *ahead; // or null for plain chunks
+        char *buffer;   // chunk buffer, or null when mapped
+        int size;       // of buffer
+        char *map;      // mapped file, or null
+        size_t mapSize;
+        char *next;     // start of unread data
+        char *end;      // end of valid data
+        bool eof;       // nothing more beyond end
+};
+
+static long freadInput(void *data, char *buffer, long size)
+{
+        FILE *fp = data;
+        size_t n = fread(buffer, 1, size, fp);
+        if (n == 0 && ferror(fp))
+                xAbort(errno, "fread");
+        return n;
+}
+
+static struct inputHandle *newInput(inputRead_fn *read, void *data)
+{
+        struct inputHandle *input = calloc(1, sizeof(*input));
+        if (input == null)
+                xAbort(errno, "calloc");
+        input->read = read;
+        input->data = data;
+        return input;
+}
+
+static void newInputBuffer(struct inputHandle *input)
+{
+        input->size = inputChunkSize;
+        input->buffer = malloc(input->size);
+        if (input->buffer == null)
+                xAbort(errno, "malloc");
+        input->next = input->buffer;
+        input->end = input->buffer;
+}
+
+xInput_t openInput(void *fp)
+{
+        struct inputHandle *input = newInput(freadInput, fp);
+        input->fp = fp;
+
+#if defined(POSIX)
+        /*
+         *  Map a regular file from its current offset on. Empty files
+         *  and anything else take the chunked path.
+         */
+        int fd = fileno(input->fp);
+        struct stat st;
+        off_t offset = lseek(fd, 0, SEEK_CUR);
+        if (offset >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > offset) {
+                void *p = mmap(null, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                        (void) posix_madvise(p, st.st_size, POSIX_MADV_SEQUENTIAL);
+                        input->map = p;
+                        input->mapSize = st.st_size;
+                        input->next = input->map + offset;
+                        input->end = input->map + st.st_size;
+                        input->eof = true;
+                        return input;
+                }
+        }
+#endif
+
+        newInputBuffer(input);
+        return input;
+}
+
+#if defined(POSIX)
+static void aheadMain(void *data)
+{
+        struct inputHandle *input = data;
+        struct inputAhead *ahead = input->ahead;
+
+        for (int i=0; ; i^=1) {
+                struct inputSlot *slot = &ahead->slots[i];
+
+                int r = pthread_mutex_lock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_lock");
+                while (slot->full && !ahead->stop) {
+                        r = pthread_cond_wait(&ahead->cond, &ahead->mutex);
+                        cAbort(r, "pthread_cond_wait");
+                }
+                bool stop = ahead->stop;
+                r = pthread_mutex_unlock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_unlock");
+                if (stop)
+                        break;
+
+                long n = input->read(input->data, slot->v + slot->headroom, inputChunkSize);
+
+                r = pthread_mutex_lock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_lock");
+                slot->len = n;
+                slot->full = true;
+                r = pthread_cond_broadcast(&ahead->cond);
+                cAbort(r, "pthread_cond_broadcast");
+                r = pthread_mutex_unlock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_unlock");
+
+                if (n == 0)
+                        break;
+        }
+}
+#endif
+
+/*
+ *  Without threads the reader simply runs in the chunked path
+ */
+xInput_t openReaderInput(inputRead_fn *read, inputClose_fn *close, void *data)
+{
+        struct inputHandle *input = newInput(read, data);
+        input->close = close;
+
+#if defined(POSIX)
+        struct inputAhead *ahead = calloc(1, sizeof(*ahead));
+        if (ahead == null)
+                xAbort(errno, "calloc");
+        for (int i=0; i<2; i++) {
+                ahead->slots[i].headroom = 1 << 16;
+                ahead->slots[i].v = malloc(ahead->slots[i].headroom + inputChunkSize);
+                if (ahead->slots[i].v == null)
+                        xAbort(errno, "malloc");
+        }
+        ahead->reading = -1;
+        int r = pthread_mutex_init(&ahead->mutex, null);
+        cAbort(r, "pthread_mutex_init");
+        r = pthread_cond_init(&ahead->cond, null);
+        cAbort(r, "pthread_cond_init");
+
+        static char empty[1];
+        input->next = empty;
+        input->end = empty;
+        input->ahead = ahead;
+        ahead->thread = createThread(aheadMain, input);
+#else
+        newInputBuffer(input);
+#endif
+        return input;
+}
+
+#if defined(POSIX)
+/*
+ *  Move the unread tail in front of the next full slot, and give the
+ *  slot that held it back to the thread
+ */
+static void refillAhead(struct inputHandle *input)
+{
+        struct inputAhead *ahead = input->ahead;
+        int keep = input->end - input->next;
+        int i = (ahead->reading < 0) ? 0 : ahead->reading ^ 1;
+        struct inputSlot *slot = &ahead->slots[i];
+
+        int r = pthread_mutex_lock(&ahead->mutex);
+        cAbort(r, "pthread_mutex_lock");
+        while (!slot->full) {
+                r = pthread_cond_wait(&ahead->cond, &ahead->mutex);
+                cAbort(r, "pthread_cond_wait");
+        }
+        r = pthread_mutex_unlock(&ahead->mutex);
+        cAbort(r, "pthread_mutex_unlock");
+
+        if (keep > slot->headroom) { // only for very long lines
+                char *v = malloc(keep + inputChunkSize);
+                if (v == null)
+                        xAbort(errno, "malloc");
+                memcpy(v + keep, slot->v + slot->headroom, slot->len);
+                free(slot->v);
+                slot->v = v;
+                slot->headroom = keep;
+        }
+        char *start = slot->v + slot->headroom - keep;
+        memcpy(start, input->next, keep);
+
+        if (ahead->reading >= 0) {
+                r = pthread_mutex_lock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_lock");
+                ahead->slots[ahead->reading].full = false;
+                r = pthread_cond_broadcast(&ahead->cond);
+                cAbort(r, "pthread_cond_broadcast");
+                r = pthread_mutex_unlock(&ahead->mutex);
+                cAbort(r, "pthread_mutex_unlock");
+        }
+        ahead->reading = i;
+
+        input->next = start;
+        input->end = slot->v + slot->headroom + slot->len;
+        if (slot->len == 0)
+                input->eof = true;
+}
+#endif
+
+/*
+ *  Keep the unread tail, and append the next chunk behind it.
+ *  Grow the buffer for lines longer than the whole buffer.
+ */
+static void refillInput(struct inputHandle *input)
+{
+#if defined(POSIX)
+        if (input->ahead != null) {
+                refillAhead(input);
+                return;
+        }
+#endif
+
+        int keep = input->end - input->next;
+        if (keep == input->size) {
+                char *buffer = realloc(input->buffer, 2 * input->size);
+                if (buffer == null)
+                        xAbort(errno, "realloc");
+                input->next = buffer + (input->next - input->buffer);
+                input->buffer = buffer;
+                input->size *= 2;
+        }
+        memmove(input->buffer, input->next, keep);
+
+        long n = input->read(input->data, input->buffer + keep, input->size - keep);
+        if (n == 0)
+                input->eof = true;
+        input->next = input->buffer;
+        input->end = input->buffer + keep + n;
+}
+
+int readSlice(xInput_t input, const char **line_p)
+{
+        for (;;) {
+                char *s = input->next;
+                char *nl = memchr(s, '\n', input->end - s);
+                if (nl != null) {
+                        input->next = nl + 1;
+                        *line_p = s;
+                        return nl + 1 - s;
+                }
+                if (input->eof) {
+                        input->next = input->end; // last line without '\n'
+                        *line_p = s;
+                        return input->end - s;
+                }
+                refillInput(input);
+        }
+}
+
+/*
+ *  Get the next 'len' bytes. Returns fewer at the end of input.
+ */
+int readBlock(xInput_t input, const char **block_p, int len)
+{
+        while (input->end - input->next < len && !input->eof)
+                refillInput(input);
+
+        int n = min(len, input->end - input->next);
+        *block_p = input->next;
+        input->next += n;
+        return n;
+}
+
+long long inputMapOffset(xInput_t input)
+{
+        return (input->map != null) ? input->next - input->map : -1;
+}
+
+void closeInput(xInput_t input)
+{
+        if (input != null) {
+#if defined(POSIX)
+                if (input->map != null) {
+                        int r = munmap(input->map, input->mapSize);
+                        if (r == -1) xAbort(errno, "munmap");
+                }
+                struct inputAhead *ahead = input->ahead;
+                if (ahead != null) {
+                        int r = pthread_mutex_lock(&ahead->mutex);
+                        cAbort(r, "pthread_mutex_lock");
+                        ahead->stop = true;
+                        r = pthread_cond_broadcast(&ahead->cond);
+                        cAbort(r, "pthread_cond_broadcast");
+                        r = pthread_mutex_unlock(&ahead->mutex);
+                        cAbort(r, "pthread_mutex_unlock");
+
+                        joinThread(ahead->thread);
+
+                        (void) pthread_mutex_destroy(&ahead->mutex);
+                        (void) pthread_cond_destroy(&ahead->cond);
+                        free(ahead->slots[0].v);
+                        free(ahead->slots[1].v);
+                        free(ahead);
+                }
+#endif
+                if (input->close != null)
+                        input->close(input->data);
+                free(input->buffer);
+                free(input);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      Large memory                                                    |
+ +----------------------------------------------------------------------*/
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_get_mempolicy)
+/*
+ *  Spread the pages over all NUMA nodes that we may use. This is a
+ *  direct system call, because libnuma is not everywhere. Failure is
+ *  harmless: the pages then come from wherever they are first touched.
+ */
+static void interleaveMemory(void *p, size_t size)
+{
+        enum { mpolInterleave = 3, mpolMemsAllowed = 4, maxNodes = 1024 };
+        unsigned long nodes[maxNodes / (8 * sizeof(unsigned long))] = { 0 };
+
+        if (syscall(SYS_get_mempolicy, null, nodes, maxNodes, null, mpolMemsAllowed) != 0)
+                return;
+
+        int nrNodes = 0;
+        for (int i=0; i<arrayLen(nodes); i++)
+                nrNodes += __builtin_popcountl(nodes[i]);
+
+        if (nrNodes > 1)
+                (void) syscall(SYS_mbind, p, size, mpolInterleave, nodes, maxNodes, 0);
+}
+#else
+static void interleaveMemory(void *p, size_t size)
+{
+        unused(p);
+        unused(size);
+}
+#endif
+
+#if defined(POSIX)
+/*
+ *  The default huge page size. Huge page mappings must be a whole
+ *  number of them, also for munmap.
+ */
+static long long hugePageSize(void)
+{
+        static long long size = 0;
+
+        if (size == 0) {
+                long long kb = 0;
+ #if defined(__linux__)
+                FILE *fp = fopen("/proc/meminfo", "r");
+                if (fp != null) {
+                        char line[128];
+                        while (fgets(line, sizeof line, fp) != null)
+                                if (sscanf(line, "Hugepagesize: %lld kB", &kb) == 1)
+                                        break;
+                        fclose(fp);
+                }
+ #endif
+                size = (kb > 0) ? kb << 10 : 2LL << 20;
+        }
+        return size;
+}
+
+/*
+ *  With memoryHugePages every mapping is rounded up to whole huge pages,
+ *  also when it falls back to normal pages. freeMemory can then round the
+ *  same way without knowing which it was.
+ */
+static long long mapSize(long long size, int flags)
+{
+        if ((flags & memoryHugePages) != 0) {
+                long long huge = hugePageSize();
+                size = (size + huge - 1) / huge * huge;
+        }
+        return size;
+}
+
+void *allocMemory(long long size, int flags)
+{
+        const int prot = PROT_READ | PROT_WRITE;
+        const int anon = MAP_PRIVATE | MAP_ANONYMOUS;
+        void *p = MAP_FAILED;
+
+        size = mapSize(size, flags);
+
+ #if defined(MAP_HUGETLB)
+        if ((flags & memoryHugePages) != 0) {
+  #if defined(MAP_HUGE_SHIFT)
+                if (size >= (1LL << 30) && size % (1LL << 30) == 0)
+                        p = mmap(null, size, prot, anon | MAP_HUGETLB | (30 << MAP_HUGE_SHIFT), -1, 0);
+  #endif
+                if (p == MAP_FAILED)
+                        p = mmap(null, size, prot, anon | MAP_HUGETLB, -1, 0);
+        }
+ #endif
+        if (p == MAP_FAILED) {
+                p = mmap(null, size, prot, anon, -1, 0);
+                if (p == MAP_FAILED)
+                        return null;
+ #if defined(MADV_HUGEPAGE)
+                if ((flags & memoryHugePages) != 0)
+                        (void) madvise(p, size, MADV_HUGEPAGE);
+ #endif
+        }
+
+        // before any page is touched
+        if ((flags & memoryInterleaved) != 0)
+                interleaveMemory(p, size);
+
+        return p;
+}
+
+void freeMemory(void *p, long long size, int flags)
+{
+        if (p != null) {
+                int r = munmap(p, mapSize(size, flags));
+                if (r == -1) xAbort(errno, "munmap");
+        }
+}
+#else
+void *allocMemory(long long size, int flags)
+{
+        unused(flags);
+        return calloc(1, size);
+}
+
+void freeMemory(void *p, long long size, int flags)
+{
+        unused(size);
+        unused(flags);
+        free(p);
+}
+#endif
+
 /*----------------------------------------------------------------------+
  |      Main support                                                    |
  +----------------------------------------------------------------------*/
@@ -259,6 +777,51 @@ void joinThread(xThread_t thread)
         WaitForSingleObject(threadHandle, INFINITE);
         CloseHandle(threadHandle);
 }
+
+struct barrierHandle {
+        CRITICAL_SECTION lock;
+        CONDITION_VARIABLE cond;
+        int nrThreads;
+        int nrWaiting;
+        unsigned int generation;
+};
+
+xBarrier_t createBarrier(int nrThreads)
+{
+        struct barrierHandle *barrier = malloc(sizeof(*barrier));
+        if (!barrier) xAbort(errno, "malloc");
+
+        InitializeCriticalSection(&barrier->lock);
+        InitializeConditionVariable(&barrier->cond);
+        barrier->nrThreads = nrThreads;
+        barrier->nrWaiting = 0;
+        barrier->generation = 0;
+
+        return barrier;
+}
+
+void waitBarrier(xBarrier_t barrier)
+{
+        EnterCriticalSection(&barrier->lock);
+        unsigned int generation = barrier->generation;
+        if (++barrier->nrWaiting == barrier->nrThreads) {
+                barrier->nrWaiting = 0;
+                barrier->generation++;
+                WakeAllConditionVariable(&barrier->cond);
+        } else {
+                while (generation == barrier->generation)
+                        SleepConditionVariableCS(&barrier->cond, &barrier->lock, INFINITE);
+        }
+        LeaveCriticalSection(&barrier->lock);
+}
+
+void destroyBarrier(xBarrier_t barrier)
+{
+        if (barrier) {
+                DeleteCriticalSection(&barrier->lock);
+                free(barrier);
+        }
+}
 #endif
 
 /*----------------------------------------------------------------------+
@@ -301,6 +864,71 @@ void joinThread(xThread_t thread)
         int r = pthread_join(threadHandle, null);
         cAbort(r, "pthread_join");
 }
+
+/*
+ *  Not pthread_barrier_t: OSX doesn't have it
+ */
+struct barrierHandle {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+        int nrThreads;
+        int nrWaiting;
+        unsigned int generation;
+};
+
+xBarrier_t createBarrier(int nrThreads)
+{
+        struct barrierHandle *barrier = malloc(sizeof(*barrier));
+        if (!barrier) xAbort(errno, "malloc");
+
+        int r = pthread_mutex_init(&barrier->mutex, null);
+        cAbort(r, "pthread_mutex_init");
+
+        r = pthread_cond_init(&barrier->cond, null);
+        cAbort(r, "pthread_cond_init");
+
+        barrier->nrThreads = nrThreads;
+        barrier->nrWaiting = 0;
+        barrier->generation = 0;
+
+        return barrier;
+}
+
+void waitBarrier(xBarrier_t barrier)
+{
+        int r = pthread_mutex_lock(&barrier->mutex);
+        cAbort(r, "pthread_mutex_lock");
+
+        unsigned int generation = barrier->generation;
+        if (++barrier->nrWaiting == barrier->nrThreads) {
+                barrier->nrWaiting = 0;
+                barrier->generation++;
+                r = pthread_cond_broadcast(&barrier->cond);
+                cAbort(r, "pthread_cond_broadcast");
+        } else {
+                while (generation == barrier->generation) {
+                        r = pthread_cond_wait(&barrier->cond, &barrier->mutex);
+                        cAbort(r, "pthread_cond_wait");
+                }
+        }
+
+        r = pthread_mutex_unlock(&barrier->mutex);
+        cAbort(r, "pthread_mutex_unlock");
+}
+
+void destroyBarrier(xBarrier_t barrier)
+{
+        if (barrier == null)
+                return;
+
+        int r = pthread_mutex_destroy(&barrier->mutex);
+        cAbort(r, "pthread_mutex_destroy");
+
+        r = pthread_cond_destroy(&barrier->cond);
+        cAbort(r, "pthread_cond_destroy");
+
+        free(barrier);
+}
 #endif
 
 /*----------------------------------------------------------------------+
@@ -160,6 +160,61 @@ char *stringCopy(char *s, const char *t);
 int compareInt(const void *ap, const void *bp);
 int readLine(void *fp, charList *lineBuffer);
 uint64_t xorshift64star(uint64_t x);
+err_t parseSize(const char *s, long long *size_p);
+long long parseLongLong(const char *s, const char *end);
+
+/*----------------------------------------------------------------------+
+ |      Input streams                                                   |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Line input without copying. readSlice points into the stream's own
+ *  memory and returns the line length including its '\n', or 0 at the
+ *  end of input. The line is not zero-terminated, and it stays valid
+ *  until the next readSlice. Regular files are mapped, other input is
+ *  read in large chunks. Open the stream before anything else reads
+ *  from the same fp.
+ */
+typedef struct inputHandle *xInput_t;
+xInput_t openInput(void *fp);
+int readSlice(xInput_t input, const char **line_p);
+int readBlock(xInput_t input, const char **block_p, int len);
+void closeInput(xInput_t input);
+
+/*
+ *  The file offset of a mapped input, up to where it has been read,
+ *  or -1 for input that isn't mapped. Reading doesn't move the offset
+ *  of the fp in that case.
+ */
+long long inputMapOffset(xInput_t input);
+
+/*
+ *  Input from a reader function, such as a decompressor. The reader
+ *  fills at most 'size' bytes and returns their number, 0 at the end.
+ *  Where threads are available it runs ahead on its own thread. The
+ *  optional close function runs in closeInput, after the reader stops.
+ */
+typedef long inputRead_fn(void *data, char *buffer, long size);
+typedef void inputClose_fn(void *data);
+xInput_t openReaderInput(inputRead_fn *read, inputClose_fn *close, void *data);
+
+/*----------------------------------------------------------------------+
+ |      Large memory                                                    |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Zero-filled memory directly from the system, for large tables.
+ *  With memoryHugePages, 1 GB pages are tried for whole multiples of
+ *  1 GB, then the default huge pages (2 MB on x86), and else
+ *  transparent huge pages are asked for. The mapping is then a whole
+ *  number of huge pages, whatever the size. With memoryInterleaved the
+ *  pages are spread over the NUMA nodes, for tables that all threads
+ *  share. Returns null when out of memory. Free with the same size and
+ *  flags.
+ */
+enum { memoryHugePages = 1, memoryInterleaved = 2 };
+void *allocMemory(long long size, int flags);
+void freeMemory(void *p, long long size, int flags);
 
 /*----------------------------------------------------------------------+
  |      Main support                                                    |
@@ -192,6 +247,16 @@ typedef void thread_fn(void *data);
 xThread_t createThread(thread_fn *function, void *data);
 void joinThread(xThread_t thread);
 
+/*
+ *  A barrier releases its threads when all nrThreads have arrived at
+ *  it, and can be used again right away. Writes before the barrier are
+ *  visible to all threads after it.
+ */
+typedef struct barrierHandle *xBarrier_t;
+xBarrier_t createBarrier(int nrThreads);
+void waitBarrier(xBarrier_t barrier);
+void destroyBarrier(xBarrier_t barrier);
+
 /*
  *  An alarm is a thread that runs its main function with a delay,
  *  and which can be safely aborted while it is waiting to run.
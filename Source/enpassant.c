@@ -85,18 +85,20 @@ void enpassant_with_white_pawn(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to] ^
-                data_zobrist[zobrist_black_pawn][victim];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to] ^
-                data_zobrist[zobrist_black_pawn][victim];
-
-        bd->current->material_key -= data_material_key[board_black_pawn];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to] ^
+                        data_zobrist[zobrist_black_pawn][victim];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to] ^
+                        data_zobrist[zobrist_black_pawn][victim];
+
+                bd->current->material_key -= data_material_key[board_black_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -242,18 +244,20 @@ void enpassant_with_black_pawn(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to] ^
-                data_zobrist[zobrist_white_pawn][victim];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to] ^
+                        data_zobrist[zobrist_white_pawn][victim];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to] ^
-                data_zobrist[zobrist_white_pawn][victim];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to] ^
+                        data_zobrist[zobrist_white_pawn][victim];
 
-        bd->current->material_key -= data_material_key[board_white_pawn];
+                bd->current->material_key -= data_material_key[board_white_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -251,32 +251,23 @@ const short exchange_put_upfront[BOARD_PIECE_TYPES] = {
 };
 
 /*
- *  The lookup table is static and thus shared with any other threads.
- *  It is filled dynamically. We assume the CPU performs atomic reads
- *  and writes, so there is no need to lock the table on access to make
- *  it thread-safe.
+ *  The exchange results of all piece lists that are possible without
+ *  promotions are precomputed by makeData into data_exchange_table[].
+ *  It is const and shared by all threads, and a lookup is one read.
+ *  Larger piece lists fall back to the calculation below.
  *
- *  We construct the table index by combining 'defenders' and 'attackers'
- *  with a shift and exclusive OR.
- * 
- *  We store the 12 bits of 'defenders' in the table slot as key.
- *  Note that storing the 'last_rank' bit is not needed because it can be
- *  derived from the index and the 12 bits key.
- *
- *  This leaves 4 bits for the value. The wanted range is from 0 (no gain)
- *  to 17 (capture a queen while promoting). 18 values doesn't fit in 4 bits
- *  though. We clip for that reason. The clipping is at +14, not +15, so that
- *  we obtain the following ranges for moves:
+ *  The result range is from 0 (no gain) to 17 (capture a queen while
+ *  promoting). We clip at +14, not +15, so that we obtain the following
+ *  ranges for moves:
  *      Good captures   0xf0?? ~ 0xfe?? (0xff?? is used for the ttable move)
  *      Regular moves   0x01?? ~ 0x0f?? (0x00?? is reserved)
- *
- *  TODO: check if 0 is a valid initializer
- *  A: only if the 'defenders != 0' stays in the outer inline function.
  */
 
-static unsigned short exchange_table[ 1 << 15 ];
-
-long long board_exchange_table_miss_counter = 0LL;
+/*
+ *  Fallback calculations, counted per thread to keep the threads off
+ *  each other's cache lines
+ */
+_Thread_local long long board_exchange_table_miss_counter = 0LL;
 
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
@@ -291,7 +282,7 @@ exchange_reset_caches(void)
 {
         err_t err = OK;
 
-        memset(&exchange_table, 0, sizeof(exchange_table));
+        /* data_exchange_table[] is constant */
 
         return err;
 }
@@ -389,7 +380,8 @@ int next_upfront(int defenders)
  *  The returned result can't be negative because the side to move has the
  *  right not to continue the exchange sequence.
  *
- *  The function caches earlier results for improved performance.
+ *  The result comes from the precomputed table when both piece lists
+ *  are in its range.
  */
 
 int exchange_evaluate_fn(int defenders, int attackers)
@@ -404,39 +396,22 @@ int exchange_evaluate_fn(int defenders, int attackers)
 
         assert((defenders & attackers & EXCHANGE_LAST_RANK) == 0);
 
-        int store = defenders & 0x0fff;
-
-        int hash = (store << 3) ^ defenders ^ attackers;
-
-        assert(hash >= 0);
-        assert(hash < 0x8000);
-
-        /*
-         *  Hashing should be such that we can reconstruct the two inputs
-         *  from the hash and the stored lower 12 bits of the defenders.
-         *  There is one ambiguity allowed: which of the two inputs has the
-         *  LAST_RANK bit set, if any.
-         *  Verify the hashing inverse with assertions.
-         */
-        assert(((hash ^ (store << 3))   & EXCHANGE_LAST_RANK) ==
-                ((attackers ^ defenders) & EXCHANGE_LAST_RANK));
-        assert(((hash ^ (store << 3) ^ store) & ~EXCHANGE_LAST_RANK) ==
-                (attackers                     & ~EXCHANGE_LAST_RANK));
-
         /*
          *  Consult the lookup table first
          */
-        unsigned short lookup = exchange_table[hash]; /* Thread-safe */
+        int d = data_exchange_list[defenders & 0x0fff];
+        int a = data_exchange_list[attackers & 0x0fff];
 
-        if (((lookup ^ defenders) & 0x0fff) == 0) {
-                assert(EXCHANGE_UNIT == 0x0100);
-                return (lookup & 0xf000) >> 4;
+        if ((d | a) >= 0) {
+                BOARD_STATS_COUNT(exchange_hits, 1);
+                return data_exchange_table[defenders >> 12][d][attackers >> 12][a] * EXCHANGE_UNIT;
         }
 
         /*
-         *  Table missed, calculate exchange sequence result
+         *  Out of range, calculate exchange sequence result
          */
         board_exchange_table_miss_counter++;
+        BOARD_STATS_COUNT(exchange_misses, 1);
 
         /*
          *  Value of captured piece
@@ -519,12 +494,6 @@ int exchange_evaluate_fn(int defenders, int attackers)
                 result = 14 * EXCHANGE_UNIT;
         }
 
-        /*
-         *  Update the lookup table and return
-         */
-
-        exchange_table[hash] = (result << 4) | store; /* Thread-safe */
-
         return result;
 }
 
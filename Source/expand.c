@@ -1,5 +1,5 @@
-
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -9,31 +9,201 @@
 #include "cplus.h"
 
 #include "board.h"
+#include "compress.h"
+#include "progress.h"
+#include "records.h"
+#include "uniq.h"
 
 /*----------------------------------------------------------------------+
  |      Data                                                            |
  +----------------------------------------------------------------------*/
 
 static long long factor = 0;
+static int output_format = record_csv;
+static FILE *output = null; // stdout, or a compressing stream into it
+static struct uniq *uniq = null; // when merging positions in-process
+static err_t emit_err = OK;
+static bool symmetric = false; // merge mirrored and color swapped positions
+static struct board *canonical_bd = null; // for formatting reduced positions
+static long long nr_emitted = 0; // of the current input position
+
+/*
+ *  Sharded output: each position goes to one of the shard files,
+ *  selected by its hash. Identical positions always meet in the
+ *  same shard, also when they come from different expand runs.
+ */
+struct shard {
+        FILE *file;
+        FILE *output; // file, or a compressing stream into it
+};
+static List(struct shard) shards = emptyList;
 
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
  +----------------------------------------------------------------------*/
 
+/*
+ *  The output for a position with this hash. With -s all positions use
+ *  record_hash, because the reduced ones don't have a board with keys.
+ *  Otherwise board_hash, so that en passant status and castling rights
+ *  count.
+ */
+static
+FILE *shard_output(unsigned long long hash)
+{
+        // the high half is the least correlated with uniq's buckets
+        unsigned long long i = ((hash >> 32) * shards.len) >> 32;
+        return shards.v[i].output;
+}
+
+static
+void emit_reduced(struct board *bd)
+{
+        struct record record;
+        (void) board_binary_record(bd, &record.pos);
+        struct board_binary pos = record.pos;
+        record_reduce(&record.pos);
+        record.count = factor;
+
+        if (uniq != null) {
+                if (emit_err == OK)
+                        emit_err = uniq_add(uniq, record_hash(&record.pos), &record);
+        } else {
+                FILE *fp = (shards.len > 0) ? shard_output(record_hash(&record.pos)) : output;
+                if (output_format == record_binary) {
+                        record_write(fp, &record);
+                } else if (memcmp(&pos, &record.pos, sizeof pos) == 0) {
+                        char fen[BOARD_MAX_FEN_STRING_SIZE];
+                        (void) board_fen_string(bd, fen);
+                        fprintf(fp, "%s,%lld\n", fen, factor);
+                } else {
+                        char fen[BOARD_MAX_FEN_STRING_SIZE];
+                        if (emit_err == OK)
+                                emit_err = board_setup_binary(canonical_bd, &record.pos);
+                        if (emit_err == OK) {
+                                (void) board_fen_string(canonical_bd, fen);
+                                fprintf(fp, "%s,%lld\n", fen, factor);
+                        }
+                }
+        }
+}
+
+static
+void emit(struct board *bd)
+{
+        nr_emitted++;
+        if (symmetric) {
+                emit_reduced(bd);
+        } else if (uniq != null) {
+                struct record record;
+                (void) board_binary_record(bd, &record.pos);
+                record.count = factor;
+                if (emit_err == OK)
+                        emit_err = uniq_add(uniq, board_hash(bd), &record);
+        } else {
+                FILE *fp = (shards.len > 0) ? shard_output(board_hash(bd)) : output;
+                if (output_format == record_binary) {
+                        struct record record;
+                        (void) board_binary_record(bd, &record.pos);
+                        record.count = factor;
+                        record_write(fp, &record);
+                } else {
+                        char fen[BOARD_MAX_FEN_STRING_SIZE];
+                        (void) board_fen_string(bd, fen);
+                        fprintf(fp, "%s,%lld\n", fen, factor);
+                }
+        }
+}
+
+/*
+ *  Write one merged position. For sharding its hash is the same as
+ *  without merging, which needs the keys of a board set up with it.
+ */
+static
+err_t emit_record(void *data, const struct record *record)
+{
+        err_t err = OK;
+        struct board *bd = data;
+        FILE *fp = output;
+
+        if (output_format == record_csv || (shards.len > 0 && !symmetric)) {
+                err = board_setup_binary(bd, &record->pos);
+                check(err);
+        }
+
+        if (shards.len > 0)
+                fp = shard_output(symmetric ? record_hash(&record->pos) : board_hash(bd));
+
+        if (output_format == record_binary)
+                record_write(fp, record);
+        else {
+                char fen[BOARD_MAX_FEN_STRING_SIZE];
+                (void) board_fen_string(bd, fen);
+                fprintf(fp, "%s,%lld\n", fen, record->count);
+        }
+cleanup:
+        return err;
+}
+
+/*
+ *  Create the shard files <prefix>.0 to <prefix>.<n-1>
+ */
+static
+err_t open_shards(const char *prefix, int nr_shards, int compress_method)
+{
+        err_t err = OK;
+        charList name = emptyList;
+
+        for (int i=0; i<nr_shards; i++) {
+                name.len = 0;
+                listPrintf(&name, "%s.%d", prefix, i);
+                struct shard shard = { .file = fopen(name.v, "wb"), .output = null };
+                if (shard.file == null)
+                        xRaise("Cannot create shard file");
+                pushList(shards, shard);
+                err = compress_open_output(shard.file, compress_method, &shards.v[i].output);
+                check(err);
+        }
+cleanup:
+        freeList(name);
+        return err;
+}
+
+/*
+ *  Close all shard files, also after an error
+ */
+static
+err_t close_shards(void)
+{
+        err_t err = OK;
+        bool failed = false;
+
+        for (int i=0; i<shards.len; i++) {
+                struct shard *shard = &shards.v[i];
+                if (shard->output != null && shard->output != shard->file)
+                        failed |= (fclose(shard->output) != 0);
+                failed |= (fclose(shard->file) != 0);
+        }
+        freeList(shards);
+
+        if (failed)
+                xRaise("Write error");
+cleanup:
+        return err;
+}
+
 static
 void expand(struct board *bd, int depth)
 {
         union board_move moves[BOARD_MAX_MOVES];
-        int nrMoves = board_generate_all_moves(bd, moves);
+        int nrMoves = board_generate_all_moves_unscored(bd, moves);
 
         depth--;
         if (!depth) {
                 for (int i=0; i<nrMoves; i++) {
-                        char fen[BOARD_MAX_FEN_STRING_SIZE];
                         board_make_move(bd, &moves[i]);
-                        (void) board_fen_string(bd, fen);
+                        emit(bd);
                         board_undo_move(bd);
-                        printf("%s,%lld\n", fen, factor);
                 }
         } else {
                 for (int i=0; i<nrMoves; i++) {
@@ -53,36 +223,185 @@ int main(int argc, char *argv[])
         err_t err = OK;
         struct board *bd = null;
         charList lineBuffer = emptyList;
+        xInput_t input = null;
+        int input_format = record_csv;
+        bool merge = false;
+        long long memory_size = 1LL << 30;
+        const char *temp_dir = null;
+        int compress_method = compress_none;
+        int nr_shards = 0;
+        const char *shard_prefix = null;
+        struct progress *progress = null;
+        double progress_interval = 0.0;
+
+        /*
+         *  Usage: expand [-i csv|bin] [-o csv|bin] [-z none|bz2|zst|lz4] [-u] [-s] [-m <size>] [-T <dir>] [-k <shards> -O <prefix>] [--progress <seconds>] <depth>
+         *
+         *  Compressed input is recognized, -z compresses the output.
+         *  Depth 0 converts between formats. With -u the output has each
+         *  position once, as with `sort | combine' but in binary record
+         *  order instead of text order. The merging then uses about
+         *  <size> memory (plain numbers are MB), and spills to temporary
+         *  files in <dir> beyond that. With -s each position without
+         *  castling rights is replaced by the smallest of its mirrored
+         *  and color swapped images. Merging then can leave fewer
+         *  positions with the same total perft count. That needs
+         *  positions without castling rights, so nothing merges in the
+         *  first ply files of the start position. With -k the output
+         *  goes to the files <prefix>.0 to <prefix>.<shards-1> instead,
+         *  each position to the one selected by its hash. Every shard can
+         *  then be merged on its own, for example on different nodes.
+         *  --progress reports the positions read and written so far to
+         *  stderr at the interval, as rmoves does.
+         */
+        int i = 1;
+        for (; i<argc && argv[i][0] == '-'; i++) {
+                if (strcmp(argv[i], "-u") == 0) {
+                        merge = true;
+                        continue;
+                }
+                if (strcmp(argv[i], "-s") == 0) {
+                        symmetric = true;
+                        continue;
+                }
+                if (i+1 >= argc)
+                        xRaise("Invalid arguments");
+                if (strcmp(argv[i], "-i") == 0) {
+                        err = record_parse_format(argv[++i], &input_format);
+                        check(err);
+                } else if (strcmp(argv[i], "-o") == 0) {
+                        err = record_parse_format(argv[++i], &output_format);
+                        check(err);
+                } else if (strcmp(argv[i], "-z") == 0) {
+                        err = compress_parse_method(argv[++i], &compress_method);
+                        check(err);
+                } else if (strcmp(argv[i], "-m") == 0) {
+                        err = parseSize(argv[++i], &memory_size);
+                        check(err);
+                } else if (strcmp(argv[i], "-T") == 0)
+                        temp_dir = argv[++i];
+                else if (strcmp(argv[i], "-k") == 0)
+                        nr_shards = atoi(argv[++i]);
+                else if (strcmp(argv[i], "-O") == 0)
+                        shard_prefix = argv[++i];
+                else if (strcmp(argv[i], "--progress") == 0)
+                        progress_interval = atof(argv[++i]);
+                else
+                        xRaise("Invalid arguments");
+        }
 
-        if (argc != 2)
+        if (i != argc-1)
                 xRaise("Invalid arguments");
 
-        int depth = atoi(argv[1]);
+        int depth = atoi(argv[i]);
+
+        if (nr_shards < 0 || (nr_shards > 0) != (shard_prefix != null))
+                xRaise("Invalid arguments");
 
         err = board_create(&bd);
         check(err);
 
-        while (readLine(stdin, &lineBuffer) != 0) {
-                if (depth == 0) {
-                        fputs(lineBuffer.v, stdout);
-                        continue;
+        // only merging and sharding look at the hash, and not with -s
+        board_set_lazy_keys(bd, !(merge || nr_shards > 0) || symmetric);
+        board_set_max_depth(bd, max(depth, 1));
+
+        if (symmetric) {
+                err = board_create(&canonical_bd);
+                check(err);
+                board_set_lazy_keys(canonical_bd, true);
+                board_set_max_depth(canonical_bd, 1);
+        }
+
+        if (merge) {
+                err = uniq_create(&uniq, memory_size, temp_dir);
+                check(err);
+        }
+
+        err = progress_create(&progress, argv[0], 1, progress_interval, stdin);
+        check(err);
+        struct progress_counter *counter = progress_counter(progress, 0);
+        progress_busy(counter);
+
+        err = compress_open_input(stdin, &input);
+        check(err);
+
+        if (nr_shards > 0) {
+                err = open_shards(shard_prefix, nr_shards, compress_method);
+                check(err);
+        } else {
+                err = compress_open_output(stdout, compress_method, &output);
+                check(err);
+        }
+
+        for (;;) {
+                if (input_format == record_binary) {
+                        struct record record;
+                        if (!record_read_input(input, &record))
+                                break;
+                        factor = record.count;
+                        err = board_setup_binary(bd, &record.pos);
+                        check(err);
+                } else {
+                        const char *line;
+                        int len = readSlice(input, &line);
+                        if (len == 0)
+                                break;
+                        if (depth == 0 && output_format == record_csv && !merge && !symmetric && nr_shards == 0) {
+                                fwrite(line, 1, len, output);
+                                progress_add(counter, 1, 1);
+                                progress_input_offset(progress, inputMapOffset(input));
+                                continue;
+                        }
+
+                        // the setup wants a terminated string
+                        int posLen = record_split_csv(line, len, &factor);
+                        lineBuffer.len = 0;
+                        preparePushList(lineBuffer, posLen + 1);
+                        memcpy(lineBuffer.v, line, posLen);
+                        lineBuffer.v[posLen] = '\0';
+                        err = board_setup_raw(bd, lineBuffer.v);
+                        check(err);
                 }
 
-                char *s = strchr(lineBuffer.v, ',');
-                if (s == null) {
-                        s = strchr(lineBuffer.v, '\n');
-                        factor = 0;
-                } else
-                        factor = atoll(s+1);
-                if (s != null)
-                        *s = '\0';
-                err = board_setup_raw(bd, lineBuffer.v);
+                if (depth == 0)
+                        emit(bd);
+                else
+                        expand(bd, depth);
+
+                progress_add(counter, 1, nr_emitted);
+                progress_input_offset(progress, inputMapOffset(input));
+                nr_emitted = 0;
+
+                err = emit_err;
+                check(err);
+        }
+
+        if (merge) {
+                err = uniq_finish(uniq, emit_record, bd);
                 check(err);
-                expand(bd, depth);
         }
 
+        if (output != stdout && output != null) {
+                FILE *fp = output;
+                output = null;
+                if (fclose(fp) != 0)
+                        xRaise("Write error");
+        }
+
+        err = close_shards();
+        check(err);
+
+        progress_idle(counter);
+
 cleanup:
+        if (output != null && output != stdout)
+                (void) fclose(output);
+        (void) close_shards();
+        progress_destroy(progress);
+        uniq_destroy(uniq);
+        board_destroy(canonical_bd);
         board_destroy(bd);
+        closeInput(input);
         freeList(lineBuffer);
         return errExitMain(err);
 }
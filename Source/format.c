@@ -35,6 +35,7 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 
 /*
@@ -209,42 +210,7 @@ err_t board_fen_string(
 
         *s++ = ' ';
 
-        int ep_square = bd->current->en_passant_lazy;
-        if (bd->current->node_counter != bd->current->en_passant_node_counter) {
-                ep_square = 0;
-        }
-        if (ep_square != 0) {
-                bool can_capture = false;
-
-                if (BOARD_RANK(ep_square) == BOARD_RANK_3) {
-                        if ((BOARD_FILE(ep_square) != BOARD_FILE_A) &&
-                            (bd->squares[ep_square + BOARD_VECTOR_NORTHWEST].piece == board_black_pawn)
-                        ) {
-                                can_capture = true;
-                        }
-                        if ((BOARD_FILE(ep_square) != BOARD_FILE_H) &&
-                            (bd->squares[ep_square + BOARD_VECTOR_NORTHEAST].piece == board_black_pawn)
-                        ) {
-                                can_capture = true;
-                        }
-                }
-                if (BOARD_RANK(ep_square) == BOARD_RANK_6) {
-                        if ((BOARD_FILE(ep_square) != BOARD_FILE_A) &&
-                            (bd->squares[ep_square + BOARD_VECTOR_SOUTHWEST].piece == board_white_pawn)
-                        ) {
-                                can_capture = true;
-                        }
-                        if ((BOARD_FILE(ep_square) != BOARD_FILE_H) &&
-                            (bd->squares[ep_square + BOARD_VECTOR_SOUTHEAST].piece == board_white_pawn)
-                        ) {
-                                can_capture = true;
-                        }
-                }
-
-                if (!can_capture) {
-                        ep_square = 0;
-                }
-        }
+        int ep_square = board_en_passant_square(bd);
         if (ep_square != 0) {
                 *s++ = 'a' + BOARD_FILE(ep_square);
                 *s++ = '1' + BOARD_RANK(ep_square);
@@ -262,6 +228,188 @@ cleanup:
         return err;
 }
 
+/*----------------------------------------------------------------------+
+ |      board_binary_record                                             |
+ +----------------------------------------------------------------------*/
+
+err_t board_binary_record(
+        struct board *bd,
+        struct board_binary *record)
+{
+        err_t err = OK;
+
+        static const signed char piece_to_code[BOARD_PIECE_TYPES] = {
+                [board_empty]              = -1,
+                [board_white_king]         = board_binary_king,
+                [board_white_king_castle]  = board_binary_king,
+                [board_white_queen]        = board_binary_queen,
+                [board_white_rook]         = board_binary_rook,
+                [board_white_rook_castle]  = board_binary_rook_castle,
+                [board_white_bishop_light] = board_binary_bishop,
+                [board_white_bishop_dark]  = board_binary_bishop,
+                [board_white_knight]       = board_binary_knight,
+                [board_white_pawn]         = board_binary_pawn,
+                [board_white_pawn_rank2]   = board_binary_pawn,
+                [board_white_pawn_rank7]   = board_binary_pawn,
+                [board_black_king]         = board_binary_black + board_binary_king,
+                [board_black_king_castle]  = board_binary_black + board_binary_king,
+                [board_black_queen]        = board_binary_black + board_binary_queen,
+                [board_black_rook]         = board_binary_black + board_binary_rook,
+                [board_black_rook_castle]  = board_binary_black + board_binary_rook_castle,
+                [board_black_bishop_light] = board_binary_black + board_binary_bishop,
+                [board_black_bishop_dark]  = board_binary_black + board_binary_bishop,
+                [board_black_knight]       = board_binary_black + board_binary_knight,
+                [board_black_pawn]         = board_binary_black + board_binary_pawn,
+                [board_black_pawn_rank2]   = board_binary_black + board_binary_pawn,
+                [board_black_pawn_rank7]   = board_binary_black + board_binary_pawn,
+        };
+
+        memset(record, 0, sizeof(*record));
+
+        /*
+         *  The pawn that can be captured en passant, if any
+         */
+        int ep_pawn = -1;
+        int ep_square = board_en_passant_square(bd);
+        if (ep_square != 0) {
+                ep_pawn = (BOARD_RANK(ep_square) == BOARD_RANK_3) ?
+                        ep_square + BOARD_VECTOR_NORTH :
+                        ep_square + BOARD_VECTOR_SOUTH;
+        }
+
+        int n = 0;
+        for (int sq=0; sq<BOARD_SIZE; sq++) {
+                int piece = bd->squares[sq].piece;
+                if (piece == board_empty) {
+                        continue;
+                }
+
+                int code = piece_to_code[piece];
+                if (sq == ep_pawn) {
+                        code += board_binary_pawn_en_passant - board_binary_pawn;
+                }
+                if (code < 0 || n >= 2 * (int) sizeof(record->pieces)) {
+                        xRaise(ERR_INTERNAL);
+                }
+
+                record->occupied[sq >> 3] |= 1 << (sq & 7);
+                record->pieces[n >> 1] |= code << ((n & 1) * 4);
+                n++;
+        }
+
+        record->side_to_move = bd->current->active.color;
+
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_move_format_simple                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Format as pure coordinate notation, such as `e2e4' or `a7b8q'.
+ *  Castling is the king move. Promotions are recognized by their
+ *  XOR-encoded to-square.
+ */
+err_t board_move_format_simple(
+        char s[BOARD_MOVE_STRING_SIZE_MAX],
+        int move)
+{
+        err_t err = OK;
+
+        int from = MOVE_FROM(move);
+        int to = MOVE_TO(move);
+        char promotion = '\0';
+
+        switch (data_sq2sq[from][to] & DATA_PROMOTION_FLAGS) {
+        case data_promotion_queen:
+                to ^= XOR_PROM_QUEEN;
+                promotion = 'q';
+                break;
+        case data_promotion_rook:
+                to ^= XOR_PROM_ROOK;
+                promotion = 'r';
+                break;
+        case data_promotion_bishop:
+                to ^= XOR_PROM_BISHOP;
+                promotion = 'b';
+                break;
+        case data_promotion_knight:
+                to ^= XOR_PROM_KNIGHT;
+                promotion = 'n';
+                break;
+        }
+
+        *s++ = 'a' + BOARD_FILE(from);
+        *s++ = '1' + BOARD_RANK(from);
+        *s++ = 'a' + BOARD_FILE(to);
+        *s++ = '1' + BOARD_RANK(to);
+        if (promotion != '\0') {
+                *s++ = promotion;
+        }
+        *s = '\0';
+
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_stats_print                                               |
+ +----------------------------------------------------------------------*/
+
+static
+double ratio(long long a, long long b)
+{
+        return (b > 0) ? (double) a / b : 0.0;
+}
+
+void board_stats_print(const struct board_stats *stats)
+{
+        static const char * const names[board_stats_nr_generators] = {
+                [board_stats_all_moves]                        = "all_moves",
+                [board_stats_all_moves_unscored]               = "all_moves_unscored",
+                [board_stats_captures_and_promotions]          = "captures_and_promotions",
+                [board_stats_captures_and_promotions_unscored] = "captures_and_promotions_unscored",
+                [board_stats_regular_moves]                    = "regular_moves",
+                [board_stats_regular_moves_unscored]           = "regular_moves_unscored",
+                [board_stats_escapes]                          = "escapes",
+                [board_stats_escapes_unscored]                 = "escapes_unscored",
+                [board_stats_count_legal_moves]                = "count_legal_moves",
+        };
+
+        fprintf(stderr, "%-32s %14s %8s %8s\n", "generator", "calls", "moves", "check");
+        for (int i=0; i<board_stats_nr_generators; i++) {
+                long long calls = stats->generate_calls[i];
+                if (calls == 0) {
+                        continue;
+                }
+                fprintf(stderr, "%-32s %14lld %8.2f %7.2f%%\n", names[i], calls,
+                        ratio(stats->generate_moves[i], calls),
+                        100.0 * ratio(stats->generate_in_check[i], calls));
+        }
+
+        long long lookups = stats->exchange_hits + stats->exchange_misses;
+        fprintf(stderr, "exchange lookups %lld, hits %.2f%%\n",
+                lookups, 100.0 * ratio(stats->exchange_hits, lookups));
+
+        long long undos = 0;
+        for (int len=0; len<=BOARD_UNDO_LEN_MAX; len++) {
+                undos += stats->undo_length[len];
+        }
+        fprintf(stderr, "undo length");
+        for (int len=0; len<=BOARD_UNDO_LEN_MAX; len++) {
+                if (stats->undo_length[len] > 0) {
+                        fprintf(stderr, " %d:%.2f%%", len,
+                                100.0 * ratio(stats->undo_length[len], undos));
+                }
+        }
+        fprintf(stderr, " (of %lld)\n", undos);
+
+        fprintf(stderr, "en passant tests %lld, false hits %.2f%%\n",
+                stats->en_passant_tests,
+                100.0 * ratio(stats->en_passant_false_hits, stats->en_passant_tests));
+}
+
 /*----------------------------------------------------------------------+
  |                                                                      |
  +----------------------------------------------------------------------*/
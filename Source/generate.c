@@ -24,6 +24,8 @@
  *  All rights reserved.
  */
 
+#if !defined(GENERATE_UNSCORED) // else this is the second instantiation
+
 /*----------------------------------------------------------------------+
  |      Includes                                                        |
  +----------------------------------------------------------------------*/
@@ -62,6 +64,49 @@
  |      Definitions                                                     |
  +----------------------------------------------------------------------*/
 
+/*
+ *  Count a generator call in the counters of its instantiation. Whether
+ *  the side to move is in check is tested here for every generator, and
+ *  only in a BOARD_STATS build.
+ */
+#define GENERATE_STATS_UNSCORED 0
+
+#define COUNT_GENERATOR(name, nr_moves) do{\
+        BOARD_STATS_COUNT(generate_calls[board_stats_##name + GENERATE_STATS_UNSCORED], 1);\
+        BOARD_STATS_COUNT(generate_moves[board_stats_##name + GENERATE_STATS_UNSCORED], nr_moves);\
+        BOARD_STATS_COUNT(generate_in_check[board_stats_##name + GENERATE_STATS_UNSCORED], board_in_check(bd));\
+}while(0)
+
+/*
+ *  Instantiate a generator for each side to move. The generators take
+ *  the side as a constant argument, so pawn directions and promotion
+ *  ranks are resolved at compile time. The side is only tested here,
+ *  once per call. (The regular moves and checks need no such thing:
+ *  they already switch on the colored piece codes.)
+ */
+#if defined(__GNUC__)
+#define GENERATE_INLINE static inline __attribute__((always_inline))
+#else
+#define GENERATE_INLINE static inline
+#endif
+
+#define GENERATE_FOR_SIDE(generate, bd, moves_p) (\
+        ((bd)->current->active.color == board_white) ?\
+                generate((bd), (moves_p), board_white) :\
+                generate((bd), (moves_p), board_black)\
+)
+
+/*
+ *  The helpers that the generators share are too large to inline at
+ *  each call. They get one out-of-line copy per side instead, and the
+ *  generator's constant side picks one (see GENERATE_SIDE_HELPERS).
+ */
+#define GENERATE_HELPER(helper, side, ...) (\
+        ((side) == board_white) ?\
+                helper##_white(__VA_ARGS__) :\
+                helper##_black(__VA_ARGS__)\
+)
+
 /*
  *  IS_LEGAL macro to check if an intended move is legal
  *  (that it doesn't expose the king to an uncovered check).
@@ -121,7 +166,7 @@
         int _move = MOVE(from, to);\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -149,7 +194,7 @@
         int _move = MOVE(from, to);\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -163,7 +208,7 @@
         int _move = MOVE(from, to);\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | EXCHANGE_NEUTRAL;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -179,7 +224,7 @@
         int _move = MOVE(from, to);\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | EXCHANGE_NEUTRAL;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -196,7 +241,7 @@
                 (exchange_piece_value[ bd->squares[to].piece ] +\
                 EXCHANGE_GOOD_MOVE_OFFSET);\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -217,7 +262,7 @@
                 EXCHANGE_UNIT +\
                 EXCHANGE_GOOD_MOVE_OFFSET);\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -260,7 +305,7 @@
         int _move = MOVE(from, to);\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) (move_maker);\
+        moves_p[nr_moves].bm.make = (move_maker);\
         (nr_moves)++;\
 }while(0)
 
@@ -343,7 +388,7 @@
         int _move = MOVE(from, to) ^ XOR_PROM_QUEEN;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_white_queen;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_white_queen);\
         (nr_moves)++;\
 \
         _attackers -= 1 << 13;\
@@ -361,7 +406,7 @@
         _move = MOVE(from, to) ^ XOR_PROM_ROOK;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_white_rook;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_white_rook);\
         (nr_moves)++;\
 \
         _attackers -= 1 << 13;\
@@ -379,13 +424,13 @@
         _move = MOVE(from, to) ^ XOR_PROM_BISHOP;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_white_bishop;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_white_bishop);\
         (nr_moves)++;\
 \
         _move = MOVE(from, to) ^ XOR_PROM_KNIGHT;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_white_knight;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_white_knight);\
         (nr_moves)++;\
 }while(0)
 
@@ -468,7 +513,7 @@
         int _move = MOVE(from, to) ^ XOR_PROM_QUEEN;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_black_queen;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_black_queen);\
         (nr_moves)++;\
 \
         _attackers -= 1 << 13;\
@@ -486,7 +531,7 @@
         _move = MOVE(from, to) ^ XOR_PROM_ROOK;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_black_rook;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_black_rook);\
         (nr_moves)++;\
 \
         _attackers -= 1 << 13;\
@@ -504,13 +549,13 @@
         _move = MOVE(from, to) ^ XOR_PROM_BISHOP;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_black_bishop;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_black_bishop);\
         (nr_moves)++;\
 \
         _move = MOVE(from, to) ^ XOR_PROM_KNIGHT;\
         moves_p[nr_moves].bm.prescore = bd->butterfly[_move].prescore | _prescore;\
         moves_p[nr_moves].bm.move = (short) _move;\
-        moves_p[nr_moves].bm.make = (voidFn*) promote_black_knight;\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_black_knight);\
         (nr_moves)++;\
 }while(0)
 
@@ -536,21 +581,21 @@
  *  Move makers for captures
  */
 static
-make_move_fn * const capture_fn_table[] = {
-        [board_white_king] = capture_with_king,
-        [board_black_king] = capture_with_king,
-        [board_white_king_castle] = capture_with_white_king_castle,
-        [board_black_king_castle] = capture_with_black_king_castle,
-        [board_white_queen] = capture_with_queen,
-        [board_black_queen] = capture_with_queen,
-        [board_white_rook] = capture_with_rook,
-        [board_black_rook] = capture_with_rook,
-        [board_white_rook_castle] = capture_with_white_rook_castle,
-        [board_black_rook_castle] = capture_with_black_rook_castle,
-        [board_white_bishop_light] = capture_with_bishop,
-        [board_black_bishop_light] = capture_with_bishop,
-        [board_white_bishop_dark] = capture_with_bishop,
-        [board_black_bishop_dark] = capture_with_bishop,
+const unsigned char capture_fn_table[] = {
+        [board_white_king] = MAKE_MOVE_ID(capture_with_king),
+        [board_black_king] = MAKE_MOVE_ID(capture_with_king),
+        [board_white_king_castle] = MAKE_MOVE_ID(capture_with_white_king_castle),
+        [board_black_king_castle] = MAKE_MOVE_ID(capture_with_black_king_castle),
+        [board_white_queen] = MAKE_MOVE_ID(capture_with_queen),
+        [board_black_queen] = MAKE_MOVE_ID(capture_with_queen),
+        [board_white_rook] = MAKE_MOVE_ID(capture_with_rook),
+        [board_black_rook] = MAKE_MOVE_ID(capture_with_rook),
+        [board_white_rook_castle] = MAKE_MOVE_ID(capture_with_white_rook_castle),
+        [board_black_rook_castle] = MAKE_MOVE_ID(capture_with_black_rook_castle),
+        [board_white_bishop_light] = MAKE_MOVE_ID(capture_with_bishop),
+        [board_black_bishop_light] = MAKE_MOVE_ID(capture_with_bishop),
+        [board_white_bishop_dark] = MAKE_MOVE_ID(capture_with_bishop),
+        [board_black_bishop_dark] = MAKE_MOVE_ID(capture_with_bishop),
         // no pawns in this table
 };
 
@@ -558,23 +603,23 @@ make_move_fn * const capture_fn_table[] = {
  *  Move makers for regular moves
  */
 static
-make_move_fn * const move_fn_table[] = {
-        [board_white_king] = move_white_king,
-        [board_black_king] = move_black_king,
-        [board_white_king_castle] = move_white_king_castle,
-        [board_black_king_castle] = move_black_king_castle,
-        [board_white_queen] = move_white_queen,
-        [board_black_queen] = move_black_queen,
-        [board_white_rook] = move_white_rook,
-        [board_black_rook] = move_black_rook,
-        [board_white_rook_castle] = move_white_rook_castle,
-        [board_black_rook_castle] = move_black_rook_castle,
-        [board_white_bishop_light] = move_white_bishop,
-        [board_black_bishop_light] = move_black_bishop,
-        [board_white_bishop_dark] = move_white_bishop,
-        [board_black_bishop_dark] = move_black_bishop,
-        [board_white_knight] = move_white_knight,
-        [board_black_knight] = move_black_knight,
+const unsigned char move_fn_table[] = {
+        [board_white_king] = MAKE_MOVE_ID(move_white_king),
+        [board_black_king] = MAKE_MOVE_ID(move_black_king),
+        [board_white_king_castle] = MAKE_MOVE_ID(move_white_king_castle),
+        [board_black_king_castle] = MAKE_MOVE_ID(move_black_king_castle),
+        [board_white_queen] = MAKE_MOVE_ID(move_white_queen),
+        [board_black_queen] = MAKE_MOVE_ID(move_black_queen),
+        [board_white_rook] = MAKE_MOVE_ID(move_white_rook),
+        [board_black_rook] = MAKE_MOVE_ID(move_black_rook),
+        [board_white_rook_castle] = MAKE_MOVE_ID(move_white_rook_castle),
+        [board_black_rook_castle] = MAKE_MOVE_ID(move_black_rook_castle),
+        [board_white_bishop_light] = MAKE_MOVE_ID(move_white_bishop),
+        [board_black_bishop_light] = MAKE_MOVE_ID(move_black_bishop),
+        [board_white_bishop_dark] = MAKE_MOVE_ID(move_white_bishop),
+        [board_black_bishop_dark] = MAKE_MOVE_ID(move_black_bishop),
+        [board_white_knight] = MAKE_MOVE_ID(move_white_knight),
+        [board_black_knight] = MAKE_MOVE_ID(move_black_knight),
         // no pawns in this table
 };
 
@@ -595,33 +640,85 @@ bool uncovers_check(
 static inline
 bool the_path_is_clear(struct board *bd, int a, int b);
 
+static
+bool _is_legal(struct board *bd, int from, int to);
+
+GENERATE_INLINE
+int count_legal_moves(struct board *bd, int side);
+
+#endif // !defined(GENERATE_UNSCORED)
+
+/*----------------------------------------------------------------------*/
+
 static
 int generate_moves_to_square(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES],
         int to);
 
-static
+GENERATE_INLINE
 int generate_captures_to_square(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES],
-        int to);
+        int to,
+        int side);
 
-static inline
+GENERATE_INLINE
 int generate_pawn_push_to(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES],
-        int to);
+        int to,
+        int side);
 
-static
+GENERATE_INLINE
 int generate_en_passant(
         struct board *bd,
-        union board_move moves_p[BOARD_MAX_MOVES]);
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side);
 
-/*----------------------------------------------------------------------*/
+/*
+ *  One copy of each helper per side
+ */
+#define GENERATE_SIDE_HELPERS(color)\
+\
+static int generate_captures_to_square_##color(\
+        struct board *bd, union board_move moves_p[BOARD_MAX_MOVES], int to)\
+{\
+        return generate_captures_to_square(bd, moves_p, to, board_##color);\
+}\
+\
+static int generate_pawn_push_to_##color(\
+        struct board *bd, union board_move moves_p[BOARD_MAX_MOVES], int to)\
+{\
+        return generate_pawn_push_to(bd, moves_p, to, board_##color);\
+}\
+\
+static int generate_en_passant_##color(\
+        struct board *bd, union board_move moves_p[BOARD_MAX_MOVES])\
+{\
+        return generate_en_passant(bd, moves_p, board_##color);\
+}
 
-static
-bool _is_legal(struct board *bd, int from, int to);
+GENERATE_SIDE_HELPERS(white)
+GENERATE_SIDE_HELPERS(black)
+
+GENERATE_INLINE
+int generate_all_moves(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side);
+
+GENERATE_INLINE
+int generate_captures_and_promotions(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side);
+
+GENERATE_INLINE
+int generate_escapes(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side);
 
 /*----------------------------------------------------------------------+
  |      board_generate_moves                                            |
@@ -633,6 +730,15 @@ bool _is_legal(struct board *bd, int from, int to);
 int board_generate_all_moves(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES])
+{
+        return GENERATE_FOR_SIDE(generate_all_moves, bd, moves_p);
+}
+
+GENERATE_INLINE
+int generate_all_moves(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side)
 {
         int nr_moves;
 
@@ -640,13 +746,13 @@ int board_generate_all_moves(
                 /*
                  *  In check, get out
                  */
-                nr_moves = board_generate_escapes(bd, moves_p);
+                nr_moves = generate_escapes(bd, moves_p, side);
         } else {
                 /*
                  *  No check, generate captures
                  */
-                nr_moves = board_generate_captures_and_promotions(
-                        bd, moves_p);
+                nr_moves = generate_captures_and_promotions(
+                        bd, moves_p, side);
 
                 /*
                  *  And regular moves
@@ -654,6 +760,7 @@ int board_generate_all_moves(
                 nr_moves += board_generate_regular_moves(
                         bd, &moves_p[nr_moves]);
         }
+        COUNT_GENERATOR(all_moves, nr_moves);
         return nr_moves;
 }
 
@@ -760,7 +867,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_white_queen);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_white_queen));
                                 } while (--len);
 
                         } while (dirs != 0);
@@ -787,7 +894,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_black_queen);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_black_queen));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -819,7 +926,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_white_rook);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_white_rook));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -847,7 +954,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_black_rook);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_black_rook));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -876,7 +983,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_white_rook_castle);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_white_rook_castle));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -888,7 +995,7 @@ int board_generate_regular_moves(
                                     (bd->current->passive.attacks[C1] == 0) &&
                                     (bd->current->passive.attacks[D1] == 0)
                                 ) {
-                                        GENERATE_KING_MOVE(E1, C1, castle_white_queen_side);
+                                        GENERATE_KING_MOVE(E1, C1, MAKE_MOVE_ID(castle_white_queen_side));
                                 }
                         } else {
                                 assert(from == H1);
@@ -898,7 +1005,7 @@ int board_generate_regular_moves(
                                     (bd->current->passive.attacks[F1] == 0) &&
                                     (bd->current->passive.attacks[G1] == 0)
                                 ) {
-                                        GENERATE_KING_MOVE(E1, G1, castle_white_king_side);
+                                        GENERATE_KING_MOVE(E1, G1, MAKE_MOVE_ID(castle_white_king_side));
                                 }
                         }
 
@@ -924,7 +1031,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_black_rook_castle);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_black_rook_castle));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -935,7 +1042,7 @@ int board_generate_regular_moves(
                                     (bd->current->passive.attacks[C8] == 0) &&
                                     (bd->current->passive.attacks[D8] == 0)
                                 ) {
-                                        GENERATE_KING_MOVE(E8, C8, castle_black_queen_side);
+                                        GENERATE_KING_MOVE(E8, C8, MAKE_MOVE_ID(castle_black_queen_side));
                                 }
                         } else {
                                 assert(from == H8);
@@ -945,7 +1052,7 @@ int board_generate_regular_moves(
                                     (bd->current->passive.attacks[F8] == 0) &&
                                     (bd->current->passive.attacks[G8] == 0)
                                 ) {
-                                        GENERATE_KING_MOVE(E8, G8, castle_black_king_side);
+                                        GENERATE_KING_MOVE(E8, G8, MAKE_MOVE_ID(castle_black_king_side));
                                 }
                         }
 
@@ -978,7 +1085,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_white_bishop);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_white_bishop));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -1007,7 +1114,7 @@ int board_generate_regular_moves(
                                         if (bd->squares[to].piece != board_empty) {
                                                 break;
                                         }
-                                        GENERATE_MOVE(from, to, move_black_bishop);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_black_bishop));
                                 } while (--len);
                         } while (dirs != 0);
 
@@ -1031,7 +1138,7 @@ int board_generate_regular_moves(
                                 to = from + board_vector_jump[dir];
 
                                 if (bd->squares[to].piece == board_empty) {
-                                        GENERATE_MOVE(from, to, move_white_knight);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_white_knight));
                                 }
                         } while (dirs != 0);
 
@@ -1051,7 +1158,7 @@ int board_generate_regular_moves(
                                 to = from + board_vector_jump[dir];
 
                                 if (bd->squares[to].piece == board_empty) {
-                                        GENERATE_MOVE(from, to, move_black_knight);
+                                        GENERATE_MOVE(from, to, MAKE_MOVE_ID(move_black_knight));
                                 }
                         } while (dirs != 0);
 
@@ -1067,7 +1174,7 @@ int board_generate_regular_moves(
                                 ((pin_dirs & board_attack_north) == 0))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_white_pawn,
+                                        MAKE_MOVE_ID(move_white_pawn),
                                         board_attack_north);
                         }
 
@@ -1079,7 +1186,7 @@ int board_generate_regular_moves(
                                 ((pin_dirs & board_attack_south) == 0))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_black_pawn,
+                                        MAKE_MOVE_ID(move_black_pawn),
                                         board_attack_south);
                         }
                         break;
@@ -1090,13 +1197,13 @@ int board_generate_regular_moves(
                                 ((pin_dirs & board_attack_north) == 0))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_white_pawn_rank2_to_3,
+                                        MAKE_MOVE_ID(move_white_pawn_rank2_to_3),
                                         board_attack_north);
 
                                 to += BOARD_VECTOR_NORTH;
                                 if (bd->squares[to].piece == board_empty) {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_white_pawn_rank2_to_4,
+                                                MAKE_MOVE_ID(move_white_pawn_rank2_to_4),
                                                 board_attack_north);
                                 }
                         }
@@ -1108,13 +1215,13 @@ int board_generate_regular_moves(
                                 ((pin_dirs & board_attack_south) == 0))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_black_pawn_rank7_to_6,
+                                        MAKE_MOVE_ID(move_black_pawn_rank7_to_6),
                                         board_attack_south);
 
                                 to += BOARD_VECTOR_SOUTH;
                                 if (bd->squares[to].piece == board_empty) {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_black_pawn_rank7_to_5,
+                                                MAKE_MOVE_ID(move_black_pawn_rank7_to_5),
                                                 board_attack_south);
                                 }
                         }
@@ -1136,6 +1243,7 @@ int board_generate_regular_moves(
                 }
         }
 
+        COUNT_GENERATOR(regular_moves, nr_moves);
         return nr_moves;
 }
 
@@ -1149,6 +1257,15 @@ int board_generate_regular_moves(
 int board_generate_captures_and_promotions(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES])
+{
+        return GENERATE_FOR_SIDE(generate_captures_and_promotions, bd, moves_p);
+}
+
+GENERATE_INLINE
+int generate_captures_and_promotions(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side)
 {
         int nr_moves = 0;
 
@@ -1183,7 +1300,7 @@ int board_generate_captures_and_promotions(
                 /*
                  *  With any piece (except king)
                  */
-                nr_moves += generate_captures_to_square(bd, &moves_p[nr_moves], to);
+                nr_moves += GENERATE_HELPER(generate_captures_to_square, side, bd, &moves_p[nr_moves], to);
         }
 
         /*------------------------------------------------------+
@@ -1204,7 +1321,7 @@ int board_generate_captures_and_promotions(
                         [ DEBRUIJN_INDEX(1<<BOARD_FILE_H) ] = BOARD_FILE_H,
                 };
 
-                if (bd->current->active.color == board_white) {
+                if (side == board_white) {
 
                         int bit = 0;
                         do {
@@ -1263,13 +1380,14 @@ int board_generate_captures_and_promotions(
          +------------------------------------------------------*/
 
         if (bd->current->en_passant_lazy != 0) {
-                nr_moves += generate_en_passant(bd, &moves_p[nr_moves]);
+                nr_moves += GENERATE_HELPER(generate_en_passant, side, bd, &moves_p[nr_moves]);
         }
 
         /*------------------------------------------------------+
          |                                                      |
          +------------------------------------------------------*/
 
+        COUNT_GENERATOR(captures_and_promotions, nr_moves);
         return nr_moves;
 }
 
@@ -1283,6 +1401,15 @@ int board_generate_captures_and_promotions(
 int board_generate_escapes(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES])
+{
+        return GENERATE_FOR_SIDE(generate_escapes, bd, moves_p);
+}
+
+GENERATE_INLINE
+int generate_escapes(
+        struct board *bd,
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side)
 {
         int nr_moves = 0;
 
@@ -1342,7 +1469,9 @@ int board_generate_escapes(
                                         &moves_p[nr_moves],
                                         to);
 
-                                nr_moves += generate_pawn_push_to(
+                                nr_moves += GENERATE_HELPER(
+                                        generate_pawn_push_to,
+                                        side,
                                         bd,
                                         &moves_p[nr_moves],
                                         to);
@@ -1355,7 +1484,7 @@ int board_generate_escapes(
                          */
 
                 } else if ((attack & board_attack_pawn_west) != 0) {
-                        if (bd->current->active.color == board_white) {
+                        if (side == board_white) {
                                 // location of black pawn
                                 to = king - BOARD_VECTOR_SOUTHWEST;
                         } else {
@@ -1367,7 +1496,9 @@ int board_generate_escapes(
                          *  Special case: en-passant capture of checking pawn
                          */
                         if (bd->current->en_passant_lazy != 0) {
-                                nr_moves += generate_en_passant(
+                                nr_moves += GENERATE_HELPER(
+                                        generate_en_passant,
+                                        side,
                                         bd,
                                         &moves_p[nr_moves]);
                         }
@@ -1377,7 +1508,7 @@ int board_generate_escapes(
                          */
 
                 } else if ((attack & board_attack_pawn_east) != 0) {
-                        if (bd->current->active.color == board_white) {
+                        if (side == board_white) {
                                 // location of black pawn
                                 to = king - BOARD_VECTOR_SOUTHEAST;
                         } else {
@@ -1389,7 +1520,9 @@ int board_generate_escapes(
                          *  Special case: en-passant capture of checking pawn
                          */
                         if (bd->current->en_passant_lazy != 0) {
-                                nr_moves += generate_en_passant(
+                                nr_moves += GENERATE_HELPER(
+                                        generate_en_passant,
+                                        side,
                                         bd,
                                         &moves_p[nr_moves]);
                         }
@@ -1423,14 +1556,16 @@ int board_generate_escapes(
          +------------------------------------------------------*/
 
                 assert(BOARD_SQUARE_IS_VALID(to));
-                assert(BOARD_PIECE_COLOR(bd->squares[to].piece) == !bd->current->active.color);
+                assert(BOARD_PIECE_COLOR(bd->squares[to].piece) == !side);
 
                 /*
                  *  Attacker identified. Generate captures.
                  */
 
                 if (bd->current->active.attacks[to] != 0) {
-                        nr_moves += generate_captures_to_square(
+                        nr_moves += GENERATE_HELPER(
+                                generate_captures_to_square,
+                                side,
                                 bd,
                                 &moves_p[nr_moves],
                                 to);
@@ -1453,7 +1588,7 @@ int board_generate_escapes(
 
                 to = from + board_vector_step_compact[DEBRUIJN_INDEX(dir)];
                 assert(to != from);
-                if ((BOARD_PIECE_COLOR(bd->squares[to].piece) != bd->current->active.color) && // @TODO: color lookup (slow?)
+                if ((BOARD_PIECE_COLOR(bd->squares[to].piece) != side) && // @TODO: color lookup (slow?)
                         (bd->current->passive.attacks[to] == 0))
                 {
                         // by construction it should be a legal move
@@ -1469,6 +1604,339 @@ int board_generate_escapes(
          |                                                      |
          +------------------------------------------------------*/
 
+        COUNT_GENERATOR(escapes, nr_moves);
+        return nr_moves;
+}
+
+#if !defined(GENERATE_UNSCORED)
+
+/*----------------------------------------------------------------------+
+ |      board_count_legal_moves                                         |
+ +----------------------------------------------------------------------*/
+
+#if defined(BOARD_BITBOARDS)
+/*
+ *  Bitboard of the king steps from square 'sq'. Squares are file-major,
+ *  so north is a shift by 1 and east a shift by 8.
+ */
+static inline
+unsigned long long king_targets(int sq)
+{
+        unsigned long long b = bit(sq);
+        b |= ((b << 1) & ~0x0101010101010101ULL) | ((b >> 1) & ~0x8080808080808080ULL);
+        b |= (b << 8) | (b >> 8);
+        return b & ~bit(sq);
+}
+
+static inline
+int pop_count(unsigned long long b)
+{
+#if defined(__GNUC__)
+        return __builtin_popcountll(b);
+#else
+        int n = 0;
+        for (; b != 0; b &= b - 1)
+                n++;
+        return n;
+#endif
+}
+
+/*
+ *  Castling needs the squares between king and rook empty, and the
+ *  squares the king passes over not attacked
+ */
+ #define CAN_CASTLE(bd, empty, safe) (\
+        (((bd)->current->active.occupied | (bd)->current->passive.occupied) & (empty)) == 0 &&\
+        ((bd)->current->passive.attacked & (safe)) == 0)
+#endif
+
+/*
+ *  Count the empty squares along a ray, plus one if it ends on an opponent
+ */
+static inline
+int count_ray(struct board *bd, int from, int dir, int xcolor)
+{
+        int vector = board_vector_step_compact[DEBRUIJN_INDEX(dir)];
+        int len = data_raylen[from][DEBRUIJN_INDEX(dir)];
+        assert(len > 0);
+
+        int to = from;
+        int nr_moves = 0;
+        do {
+                to += vector;
+                int piece = bd->squares[to].piece;
+                if (piece != board_empty) {
+                        return nr_moves + (BOARD_PIECE_COLOR(piece) == xcolor);
+                }
+                nr_moves++;
+        } while (--len);
+
+        return nr_moves;
+}
+
+/*
+ *  Count the legal moves without generating them
+ *
+ *  Gives the same number as board_generate_all_moves(). Only positions
+ *  with check or en-passant fall back to the generator. Otherwise it is
+ *  a walk over the pieces with the same pin test as in the generator,
+ *  without any move stores or exchange evaluation.
+ */
+int board_count_legal_moves(struct board *bd)
+{
+        if (bd->current->active.color == board_white)
+                return count_legal_moves(bd, board_white);
+        else
+                return count_legal_moves(bd, board_black);
+}
+
+GENERATE_INLINE
+int count_legal_moves(struct board *bd, int side)
+{
+        if (board_in_check(bd)) {
+                union board_move moves[BOARD_MAX_MOVES];
+                int nr_moves = board_generate_escapes_unscored(bd, moves);
+                COUNT_GENERATOR(count_legal_moves, nr_moves);
+                return nr_moves;
+        }
+
+        int nr_moves = 0;
+
+        if (bd->current->en_passant_lazy != 0) {
+                union board_move moves[BOARD_MAX_MOVES];
+                nr_moves += GENERATE_HELPER(generate_en_passant, side, bd, moves);
+        }
+
+        signed char *pieces = &bd->current->active.pieces[0];
+        int xcolor = !side;
+
+        int from, to, piece;
+        int dir, dirs;
+
+        /*
+         *  King moves and captures
+         */
+        from = *pieces;
+        assert(bd->current->passive.attacks[from] == 0);
+
+#if defined(BOARD_BITBOARDS)
+        nr_moves += pop_count(king_targets(from) &
+                ~bd->current->active.occupied &
+                ~bd->current->passive.attacked);
+#else
+        dirs = data_kingtab[from];
+        dir = 0;
+        do {
+                dir -= dirs;
+                dir &= dirs;
+                dirs -= dir;
+
+                to = from + board_vector_step_compact[DEBRUIJN_INDEX(dir)];
+                piece = bd->squares[to].piece;
+                if ((BOARD_PIECE_COLOR(piece) != !xcolor) &&
+                    (bd->current->passive.attacks[to] == 0)
+                ) {
+                        nr_moves++;
+                }
+        } while (dirs != 0);
+#endif
+
+        /*
+         *  Remaining pieces
+         */
+        int king = from;
+
+        while ((from = *++pieces) >= 0) {
+
+                int pin_dirs =
+                        bd->current->passive.attacks[from] &
+                        data_sq2sq[from][king] &
+                        BOARD_ATTACK_QUEEN;
+
+                if (pin_dirs != 0) {
+                        if (the_path_is_clear(bd, from, king)) {
+                                pin_dirs |= BOARD_ATTACK_REVERSE(pin_dirs);
+                                pin_dirs = ~pin_dirs;
+                        } else {
+                                pin_dirs = 0;
+                        }
+                }
+
+                switch (bd->squares[from].piece) {
+
+                case board_white_queen:
+                case board_black_queen:
+                        dirs = data_kingtab[from] & ~pin_dirs;
+                        break;
+
+                case board_white_rook:
+                case board_black_rook:
+                        dirs = data_kingtab[from] & BOARD_ATTACK_ROOK & ~pin_dirs;
+                        break;
+
+                case board_white_bishop_light:
+                case board_white_bishop_dark:
+                case board_black_bishop_light:
+                case board_black_bishop_dark:
+                        dirs = data_kingtab[from] & BOARD_ATTACK_BISHOP & ~pin_dirs;
+                        break;
+
+                case board_white_rook_castle:
+                        dirs = data_kingtab[from] & BOARD_ATTACK_ROOK;
+#if defined(BOARD_BITBOARDS)
+                        if (from == A1) {
+                                nr_moves += CAN_CASTLE(bd,
+                                        bit(B1) | bit(C1) | bit(D1),
+                                        bit(C1) | bit(D1));
+                        } else {
+                                nr_moves += CAN_CASTLE(bd,
+                                        bit(F1) | bit(G1),
+                                        bit(F1) | bit(G1));
+                        }
+#else
+                        if (from == A1) {
+                                nr_moves +=
+                                        (bd->squares[B1].piece == board_empty) &&
+                                        (bd->squares[C1].piece == board_empty) &&
+                                        (bd->squares[D1].piece == board_empty) &&
+                                        (bd->current->passive.attacks[C1] == 0) &&
+                                        (bd->current->passive.attacks[D1] == 0);
+                        } else {
+                                nr_moves +=
+                                        (bd->squares[F1].piece == board_empty) &&
+                                        (bd->squares[G1].piece == board_empty) &&
+                                        (bd->current->passive.attacks[F1] == 0) &&
+                                        (bd->current->passive.attacks[G1] == 0);
+                        }
+#endif
+                        break;
+
+                case board_black_rook_castle:
+                        dirs = data_kingtab[from] & BOARD_ATTACK_ROOK;
+#if defined(BOARD_BITBOARDS)
+                        if (from == A8) {
+                                nr_moves += CAN_CASTLE(bd,
+                                        bit(B8) | bit(C8) | bit(D8),
+                                        bit(C8) | bit(D8));
+                        } else {
+                                nr_moves += CAN_CASTLE(bd,
+                                        bit(F8) | bit(G8),
+                                        bit(F8) | bit(G8));
+                        }
+#else
+                        if (from == A8) {
+                                nr_moves +=
+                                        (bd->squares[B8].piece == board_empty) &&
+                                        (bd->squares[C8].piece == board_empty) &&
+                                        (bd->squares[D8].piece == board_empty) &&
+                                        (bd->current->passive.attacks[C8] == 0) &&
+                                        (bd->current->passive.attacks[D8] == 0);
+                        } else {
+                                nr_moves +=
+                                        (bd->squares[F8].piece == board_empty) &&
+                                        (bd->squares[G8].piece == board_empty) &&
+                                        (bd->current->passive.attacks[F8] == 0) &&
+                                        (bd->current->passive.attacks[G8] == 0);
+                        }
+#endif
+                        break;
+
+                case board_white_knight:
+                case board_black_knight:
+                        if (pin_dirs == 0) {
+                                dirs = data_knighttab[from];
+                                dir = 0;
+                                do {
+                                        dir -= dirs;
+                                        dir &= dirs;
+                                        dirs -= dir;
+
+                                        piece = bd->squares[from + board_vector_jump[dir]].piece;
+                                        nr_moves += BOARD_PIECE_COLOR(piece) != !xcolor;
+                                } while (dirs != 0);
+                        }
+                        continue;
+
+                /*
+                 *  Pawns: each promotion counts as four moves
+                 */
+                case board_white_pawn:
+                case board_white_pawn_rank2:
+                case board_white_pawn_rank7: {
+                        int n = (bd->squares[from].piece == board_white_pawn_rank7) ? 4 : 1;
+
+                        to = from + BOARD_VECTOR_NORTH;
+                        if ((bd->squares[to].piece == board_empty) &&
+                            ((pin_dirs & board_attack_north) == 0)
+                        ) {
+                                nr_moves += n;
+                                if ((bd->squares[from].piece == board_white_pawn_rank2) &&
+                                    (bd->squares[to + BOARD_VECTOR_NORTH].piece == board_empty)
+                                ) {
+                                        nr_moves++;
+                                }
+                        }
+                        if (((data_kingtab[from] & ~pin_dirs & board_attack_northwest) != 0) &&
+                            (BOARD_PIECE_COLOR(bd->squares[from + BOARD_VECTOR_NORTHWEST].piece) == xcolor)
+                        ) {
+                                nr_moves += n;
+                        }
+                        if (((data_kingtab[from] & ~pin_dirs & board_attack_northeast) != 0) &&
+                            (BOARD_PIECE_COLOR(bd->squares[from + BOARD_VECTOR_NORTHEAST].piece) == xcolor)
+                        ) {
+                                nr_moves += n;
+                        }
+                        continue;
+                }
+
+                case board_black_pawn:
+                case board_black_pawn_rank7:
+                case board_black_pawn_rank2: {
+                        int n = (bd->squares[from].piece == board_black_pawn_rank2) ? 4 : 1;
+
+                        to = from + BOARD_VECTOR_SOUTH;
+                        if ((bd->squares[to].piece == board_empty) &&
+                            ((pin_dirs & board_attack_south) == 0)
+                        ) {
+                                nr_moves += n;
+                                if ((bd->squares[from].piece == board_black_pawn_rank7) &&
+                                    (bd->squares[to + BOARD_VECTOR_SOUTH].piece == board_empty)
+                                ) {
+                                        nr_moves++;
+                                }
+                        }
+                        if (((data_kingtab[from] & ~pin_dirs & board_attack_southwest) != 0) &&
+                            (BOARD_PIECE_COLOR(bd->squares[from + BOARD_VECTOR_SOUTHWEST].piece) == xcolor)
+                        ) {
+                                nr_moves += n;
+                        }
+                        if (((data_kingtab[from] & ~pin_dirs & board_attack_southeast) != 0) &&
+                            (BOARD_PIECE_COLOR(bd->squares[from + BOARD_VECTOR_SOUTHEAST].piece) == xcolor)
+                        ) {
+                                nr_moves += n;
+                        }
+                        continue;
+                }
+
+                default:
+                        assert(false);
+                        continue;
+                }
+
+                /*
+                 *  Sliding pieces
+                 */
+                dir = 0;
+                while (dirs != 0) {
+                        dir -= dirs;
+                        dir &= dirs;
+                        dirs -= dir;
+
+                        nr_moves += count_ray(bd, from, dir, xcolor);
+                }
+        }
+
+        COUNT_GENERATOR(count_legal_moves, nr_moves);
         return nr_moves;
 }
 
@@ -1577,11 +2045,11 @@ int board_generate_regular_checks(
                                                 ) {
                                                         if (bd->squares[from].piece == board_white_pawn) {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_white_pawn,
+                                                                        MAKE_MOVE_ID(move_white_pawn),
                                                                         board_attack_north);
                                                         } else {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_white_pawn_rank2_to_3,
+                                                                        MAKE_MOVE_ID(move_white_pawn_rank2_to_3),
                                                                         board_attack_north);
                                                         }
                                                 }
@@ -1598,12 +2066,12 @@ int board_generate_regular_checks(
                                                 ) {
                                                         if (bd->squares[from].piece == board_white_pawn) {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_white_pawn,
+                                                                        MAKE_MOVE_ID(move_white_pawn),
                                                                         board_attack_north);
                                                         } else {
                                                                 assert(bd->squares[from].piece == board_white_pawn_rank2);
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_white_pawn_rank2_to_3,
+                                                                        MAKE_MOVE_ID(move_white_pawn_rank2_to_3),
                                                                         board_attack_north);
                                                         }
                                                 }
@@ -1630,7 +2098,7 @@ int board_generate_regular_checks(
                                                     !the_path_is_clear(bd, from, king)
                                                 ) {
                                                         GENERATE_PAWN_MOVE(from, to,
-                                                                move_white_pawn_rank2_to_4,
+                                                                MAKE_MOVE_ID(move_white_pawn_rank2_to_4),
                                                                 board_attack_north);
                                                 }
                                         }
@@ -1648,7 +2116,7 @@ int board_generate_regular_checks(
                                                     !the_path_is_clear(bd, from, king)
                                                 ) {
                                                         GENERATE_PAWN_MOVE(from, to,
-                                                                move_white_pawn_rank2_to_4,
+                                                                MAKE_MOVE_ID(move_white_pawn_rank2_to_4),
                                                                 board_attack_north);
                                                 }
                                         }
@@ -1706,11 +2174,11 @@ int board_generate_regular_checks(
                                                 ) {
                                                         if (bd->squares[from].piece == board_black_pawn) {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_black_pawn,
+                                                                        MAKE_MOVE_ID(move_black_pawn),
                                                                         board_attack_south);
                                                         } else {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_black_pawn_rank7_to_6,
+                                                                        MAKE_MOVE_ID(move_black_pawn_rank7_to_6),
                                                                         board_attack_south);
                                                         }
                                                 }
@@ -1728,11 +2196,11 @@ int board_generate_regular_checks(
                                                 ) {
                                                         if (bd->squares[from].piece == board_black_pawn) {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_black_pawn,
+                                                                        MAKE_MOVE_ID(move_black_pawn),
                                                                         board_attack_south);
                                                         } else {
                                                                 GENERATE_PAWN_MOVE(from, to,
-                                                                        move_black_pawn_rank7_to_6,
+                                                                        MAKE_MOVE_ID(move_black_pawn_rank7_to_6),
                                                                         board_attack_south);
                                                         }
                                                 }
@@ -1759,7 +2227,7 @@ int board_generate_regular_checks(
                                                     !the_path_is_clear(bd, from, king)
                                                 ) {
                                                         GENERATE_PAWN_MOVE(from, to,
-                                                                move_black_pawn_rank7_to_5,
+                                                                MAKE_MOVE_ID(move_black_pawn_rank7_to_5),
                                                                 board_attack_south);
                                                 }
                                         }
@@ -1777,7 +2245,7 @@ int board_generate_regular_checks(
                                                     !the_path_is_clear(bd, from, king)
                                                 ) {
                                                         GENERATE_PAWN_MOVE(from, to,
-                                                                move_black_pawn_rank7_to_5,
+                                                                MAKE_MOVE_ID(move_black_pawn_rank7_to_5),
                                                                 board_attack_south);
                                                 }
                                         }
@@ -1842,7 +2310,7 @@ int board_generate_regular_checks(
                             (bd->squares[to].piece == board_empty) &&
                             ((pin_dirs & board_attack_north) == 0)
                         ) {
-                                GENERATE_PAWN_MOVE(from, to, move_white_pawn, board_attack_north);
+                                GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_white_pawn), board_attack_north);
                         }
                         break;
 
@@ -1856,11 +2324,11 @@ int board_generate_regular_checks(
                             (bd->squares[to].piece == board_empty) &&
                             ((pin_dirs & board_attack_north) == 0)
                         ) {
-                                GENERATE_PAWN_MOVE(from, to, move_white_pawn_rank2_to_3, board_attack_north);
+                                GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_white_pawn_rank2_to_3), board_attack_north);
 
                                 to += BOARD_VECTOR_NORTH;
                                 if (bd->squares[to].piece == board_empty) {
-                                        GENERATE_PAWN_MOVE(from, to, move_white_pawn_rank2_to_4, board_attack_north);
+                                        GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_white_pawn_rank2_to_4), board_attack_north);
                                 }
                         }
                         break;
@@ -1875,7 +2343,7 @@ int board_generate_regular_checks(
                             (bd->squares[to].piece == board_empty) &&
                             ((pin_dirs & board_attack_south) == 0)
                         ) {
-                                GENERATE_PAWN_MOVE(from, to, move_black_pawn, board_attack_south);
+                                GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_black_pawn), board_attack_south);
                         }
                         break;
 
@@ -1889,11 +2357,11 @@ int board_generate_regular_checks(
                             (bd->squares[to].piece == board_empty) &&
                             ((pin_dirs & board_attack_south) == 0)
                         ) {
-                                GENERATE_PAWN_MOVE(from, to, move_black_pawn_rank7_to_6, board_attack_south);
+                                GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_black_pawn_rank7_to_6), board_attack_south);
 
                                 to += BOARD_VECTOR_SOUTH;
                                 if (bd->squares[to].piece == board_empty) {
-                                        GENERATE_PAWN_MOVE(from, to, move_black_pawn_rank7_to_5, board_attack_south);
+                                        GENERATE_PAWN_MOVE(from, to, MAKE_MOVE_ID(move_black_pawn_rank7_to_5), board_attack_south);
                                 }
                         }
                         break;
@@ -2013,7 +2481,7 @@ int board_generate_regular_checks(
                                             (bd->current->passive.attacks[C1] == 0) &&
                                             (bd->current->passive.attacks[D1] == 0)
                                         ) {
-                                                GENERATE_KING_MOVE(E1, C1, castle_white_queen_side);
+                                                GENERATE_KING_MOVE(E1, C1, MAKE_MOVE_ID(castle_white_queen_side));
                                         }
                                 }
                                 break;
@@ -2026,7 +2494,7 @@ int board_generate_regular_checks(
                                             (bd->current->passive.attacks[F1] == 0) &&
                                             (bd->current->passive.attacks[G1] == 0)
                                         ) {
-                                                GENERATE_KING_MOVE(E1, G1, castle_white_king_side);
+                                                GENERATE_KING_MOVE(E1, G1, MAKE_MOVE_ID(castle_white_king_side));
                                         }
                                 }
                                 break;
@@ -2040,7 +2508,7 @@ int board_generate_regular_checks(
                                             (bd->current->passive.attacks[C8] == 0) &&
                                             (bd->current->passive.attacks[D8] == 0)
                                         ) {
-                                                GENERATE_KING_MOVE(E8, C8, castle_black_queen_side);
+                                                GENERATE_KING_MOVE(E8, C8, MAKE_MOVE_ID(castle_black_queen_side));
                                         }
                                 }
                                 break;
@@ -2053,7 +2521,7 @@ int board_generate_regular_checks(
                                             (bd->current->passive.attacks[F8] == 0) &&
                                             (bd->current->passive.attacks[G8] == 0)
                                         ) {
-                                                GENERATE_KING_MOVE(E8, G8, castle_black_king_side);
+                                                GENERATE_KING_MOVE(E8, G8, MAKE_MOVE_ID(castle_black_king_side));
                                         }
                                 }
                                 break;
@@ -2294,6 +2762,8 @@ bool the_path_is_clear(struct board *bd, int a, int b)
         return true;
 }
 
+#endif // !defined(GENERATE_UNSCORED)
+
 /*----------------------------------------------------------------------+
  |      generate_moves_to_square                                        |
  +----------------------------------------------------------------------*/
@@ -2381,15 +2851,18 @@ int generate_moves_to_square(
  *  Generate any move to the destination square, except
  *  pawn pushes and king moves (but including pawn captures).
  */
-static
+GENERATE_INLINE
 int generate_captures_to_square(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES],
-        int to)
+        int to,
+        int side)
 {
         int nr_moves = 0;
 
+#if !defined(GENERATE_UNSCORED)
         int attackers = 0;
+#endif
         int piece;
         int bits = bd->current->active.attacks[to];
 
@@ -2401,7 +2874,7 @@ int generate_captures_to_square(
          */
         struct {
                 int from;
-                make_move_fn *make;
+                unsigned char make;
         } captures[BOARD_SIDE_MAX_PIECES];
         int nr_captures = 0;
 
@@ -2410,9 +2883,11 @@ int generate_captures_to_square(
          */
         if ((bits & board_attack_pawn_west) != 0) {
 
+#if !defined(GENERATE_UNSCORED)
                 attackers += EXCHANGE_LIST_PAWN;
+#endif
 
-                if (bd->current->active.color == board_white) {
+                if (side == board_white) {
                         int from = to - BOARD_VECTOR_NORTHWEST;
                         piece = bd->squares[from].piece;
                         assert(BOARD_PIECE_COLOR(piece) == board_white);
@@ -2420,9 +2895,10 @@ int generate_captures_to_square(
                                 if (BOARD_RANK(to) != BOARD_RANK_8) {
                                         assert(nr_captures < BOARD_SIDE_MAX_PIECES);
                                         captures[nr_captures].from = from;
-                                        captures[nr_captures].make = capture_with_white_pawn;
+                                        captures[nr_captures].make = MAKE_MOVE_ID(capture_with_white_pawn);
                                         nr_captures++;
 
+#if !defined(GENERATE_UNSCORED)
                                         /* Find extra defenders behind the pawn */
                                         bd->extra_defenders[from] = 0;
                                         int extra_bit =
@@ -2433,11 +2909,13 @@ int generate_captures_to_square(
                                                         exchange_collect_extra_defenders(
                                                                 bd, from, extra_bit);
                                         }
+#endif
                                 } else {
                                         GENERATE_WHITE_PROMOTION(from, to);
                                 }
                         }
 
+#if !defined(GENERATE_UNSCORED)
                         /* Find attackers behind the pawn */
                         while ((bd->current->active.attacks[from] & board_attack_northwest) != 0) {
                                 do {
@@ -2448,6 +2926,7 @@ int generate_captures_to_square(
                                 assert(BOARD_PIECE_COLOR(piece) == bd->current->active.color);
                                 attackers += exchange_piece_to_list[piece];
                         }
+#endif
                 } else {
                         int from = to - BOARD_VECTOR_SOUTHWEST;
                         piece = bd->squares[from].piece;
@@ -2456,9 +2935,10 @@ int generate_captures_to_square(
                                 if (BOARD_RANK(to) != BOARD_RANK_1) {
                                         assert(nr_captures < BOARD_SIDE_MAX_PIECES);
                                         captures[nr_captures].from = from;
-                                        captures[nr_captures].make = capture_with_black_pawn;
+                                        captures[nr_captures].make = MAKE_MOVE_ID(capture_with_black_pawn);
                                         nr_captures++;
 
+#if !defined(GENERATE_UNSCORED)
                                         /* Find extra defenders behind the pawn */
                                         bd->extra_defenders[from] = 0;
                                         int extra_bit =
@@ -2469,11 +2949,13 @@ int generate_captures_to_square(
                                                         exchange_collect_extra_defenders(
                                                                 bd, from, extra_bit);
                                         }
+#endif
                                 } else {
                                         GENERATE_BLACK_PROMOTION(from, to);
                                 }
                         }
 
+#if !defined(GENERATE_UNSCORED)
                         /* Find attackers behind the pawn */
                         while ((bd->current->active.attacks[from] & board_attack_southwest) != 0) {
                                 do {
@@ -2484,6 +2966,7 @@ int generate_captures_to_square(
                                 assert(BOARD_PIECE_COLOR(piece) == bd->current->active.color);
                                 attackers += exchange_piece_to_list[piece];
                         }
+#endif
                 }
         }
 
@@ -2492,9 +2975,11 @@ int generate_captures_to_square(
          */
         if ((bits & board_attack_pawn_east) != 0) {
 
+#if !defined(GENERATE_UNSCORED)
                 attackers += EXCHANGE_LIST_PAWN;
+#endif
 
-                if (bd->current->active.color == board_white) {
+                if (side == board_white) {
                         int from = to - BOARD_VECTOR_NORTHEAST;
                         piece = bd->squares[from].piece;
                         assert(BOARD_PIECE_COLOR(piece) == board_white);
@@ -2502,9 +2987,10 @@ int generate_captures_to_square(
                                 if (BOARD_RANK(to) != BOARD_RANK_8) {
                                         assert(nr_captures < BOARD_SIDE_MAX_PIECES);
                                         captures[nr_captures].from = from;
-                                        captures[nr_captures].make = capture_with_white_pawn;
+                                        captures[nr_captures].make = MAKE_MOVE_ID(capture_with_white_pawn);
                                         nr_captures++;
 
+#if !defined(GENERATE_UNSCORED)
                                         /* Find extra defenders behind the pawn */
                                         bd->extra_defenders[from] = 0;
                                         int extra_bit =
@@ -2515,11 +3001,13 @@ int generate_captures_to_square(
                                                         exchange_collect_extra_defenders(
                                                                 bd, from, extra_bit);
                                         }
+#endif
                                 } else {
                                         GENERATE_WHITE_PROMOTION(from, to);
                                 }
                         }
 
+#if !defined(GENERATE_UNSCORED)
                         /* Find attackers behind the pawn */
                         while ((bd->current->active.attacks[from] & board_attack_northeast) != 0) {
                                 do {
@@ -2530,6 +3018,7 @@ int generate_captures_to_square(
                                 assert(BOARD_PIECE_COLOR(piece) == bd->current->active.color);
                                 attackers += exchange_piece_to_list[piece];
                         }
+#endif
                 } else {
                         int from = to - BOARD_VECTOR_SOUTHEAST;
                         piece = bd->squares[from].piece;
@@ -2538,9 +3027,10 @@ int generate_captures_to_square(
                                 if (BOARD_RANK(to) != BOARD_RANK_1) {
                                         assert(nr_captures < BOARD_SIDE_MAX_PIECES);
                                         captures[nr_captures].from = from;
-                                        captures[nr_captures].make = capture_with_black_pawn;
+                                        captures[nr_captures].make = MAKE_MOVE_ID(capture_with_black_pawn);
                                         nr_captures++;
 
+#if !defined(GENERATE_UNSCORED)
                                         /* Find extra defenders behind the pawn */
                                         bd->extra_defenders[from] = 0;
                                         int extra_bit =
@@ -2551,11 +3041,13 @@ int generate_captures_to_square(
                                                         exchange_collect_extra_defenders(
                                                                 bd, from, extra_bit);
                                         }
+#endif
                                 } else {
                                         GENERATE_BLACK_PROMOTION(from, to);
                                 }
                         }
 
+#if !defined(GENERATE_UNSCORED)
                         /* Find attackers behind the pawn */
                         while ((bd->current->active.attacks[from] & board_attack_southeast) != 0) {
                                 do {
@@ -2566,6 +3058,7 @@ int generate_captures_to_square(
                                 assert(BOARD_PIECE_COLOR(piece) == bd->current->active.color);
                                 attackers += exchange_piece_to_list[piece];
                         }
+#endif
                 }
         }
 
@@ -2573,7 +3066,9 @@ int generate_captures_to_square(
          *  With king
          */
         if ((bits & board_attack_king) != 0) {
+#if !defined(GENERATE_UNSCORED)
                 attackers += EXCHANGE_LIST_ROYAL;
+#endif
                 /* Don't generate king moves here */
         }
 
@@ -2584,7 +3079,9 @@ int generate_captures_to_square(
                 signed char *knights = &bd->current->active.pieces[1];
 
                 do {
+#if !defined(GENERATE_UNSCORED)
                         attackers += EXCHANGE_LIST_MINOR;
+#endif
 
                         bits -= board_attack_knight;
 
@@ -2602,9 +3099,11 @@ int generate_captures_to_square(
                         if (IS_LEGAL(from, to)) {
                                 assert(nr_captures < BOARD_SIDE_MAX_PIECES);
                                 captures[nr_captures].from = from;
-                                captures[nr_captures].make = capture_with_knight;
+                                captures[nr_captures].make = MAKE_MOVE_ID(capture_with_knight);
                                 nr_captures++;
+#if !defined(GENERATE_UNSCORED)
                                 bd->extra_defenders[from] = 0;
+#endif
                         }
                 } while (bits >= board_attack_knight);
         }
@@ -2633,7 +3132,9 @@ int generate_captures_to_square(
 
                         assert(BOARD_PIECE_COLOR(piece) == bd->current->active.color);
 
+#if !defined(GENERATE_UNSCORED)
                         attackers += exchange_piece_to_list[piece];
+#endif
 
                         if (IS_LEGAL(from, to)) {
                                 assert(nr_captures < BOARD_SIDE_MAX_PIECES);
@@ -2641,6 +3142,7 @@ int generate_captures_to_square(
                                 captures[nr_captures].make = capture_fn_table[piece];
                                 nr_captures++;
 
+#if !defined(GENERATE_UNSCORED)
                                 /* Find extra defenders behind the piece */
                                 bd->extra_defenders[from] = 0;
                                 int extra_bit =
@@ -2651,8 +3153,10 @@ int generate_captures_to_square(
                                                 exchange_collect_extra_defenders(
                                                         bd, from, extra_bit);
                                 }
+#endif
                         }
 
+#if !defined(GENERATE_UNSCORED)
                         /*
                          *  Find more attackers to complete the SEE attack list,
                          *  also if the move is illegal.
@@ -2669,10 +3173,12 @@ int generate_captures_to_square(
 
                                 attackers += exchange_piece_to_list[piece];
                         }
+#endif
 
                 } while (dirs != 0);
         }
 
+#if !defined(GENERATE_UNSCORED)
         assert(attackers != 0);
 
         /*------------------------------------------------------+
@@ -2760,9 +3266,20 @@ int generate_captures_to_square(
                 int move = MOVE(from, to);
                 moves_p[nr_moves].bm.move = move;
                 moves_p[nr_moves].bm.prescore = bd->butterfly[move].prescore | prescore;
-                moves_p[nr_moves].bm.make = (voidFn*) captures[nr_captures].make;
+                moves_p[nr_moves].bm.make = captures[nr_captures].make;
+                (nr_moves)++;
+        }
+#else
+        while (nr_captures != 0) {
+                nr_captures--;
+
+                int move = MOVE(captures[nr_captures].from, to);
+                moves_p[nr_moves].bm.move = move;
+                moves_p[nr_moves].bm.prescore = 0;
+                moves_p[nr_moves].bm.make = captures[nr_captures].make;
                 (nr_moves)++;
         }
+#endif
 
         return nr_moves;
 }
@@ -2774,11 +3291,12 @@ int generate_captures_to_square(
 /*
  *  Generate pawn moves to a specified square (not capturing)
  */
-static inline
+GENERATE_INLINE
 int generate_pawn_push_to(
         struct board *bd,
         union board_move moves_p[BOARD_MAX_MOVES],
-        int to)
+        int to,
+        int side)
 {
         int nr_moves = 0;
 
@@ -2789,7 +3307,7 @@ int generate_pawn_push_to(
 
         int from;
 
-        if (bd->current->active.color == board_white) {
+        if (side == board_white) {
                 /*
                  *  Search white pawn to push
                  */
@@ -2803,7 +3321,7 @@ int generate_pawn_push_to(
                                 IS_LEGAL(from, to))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_white_pawn_rank2_to_3,
+                                        MAKE_MOVE_ID(move_white_pawn_rank2_to_3),
                                         board_attack_north);
                         }
                         break;
@@ -2812,7 +3330,7 @@ int generate_pawn_push_to(
                         if (bd->squares[from].piece == board_white_pawn) {
                                 if (IS_LEGAL(from, to)) {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_white_pawn,
+                                                MAKE_MOVE_ID(move_white_pawn),
                                                 board_attack_north);
                                 }
                         } else if (bd->squares[from].piece == board_empty) {
@@ -2821,7 +3339,7 @@ int generate_pawn_push_to(
                                         IS_LEGAL(from, to))
                                 {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_white_pawn_rank2_to_4,
+                                                MAKE_MOVE_ID(move_white_pawn_rank2_to_4),
                                                 board_attack_north);
                                 }
                         } else {
@@ -2836,7 +3354,7 @@ int generate_pawn_push_to(
                                 IS_LEGAL(from, to))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_white_pawn,
+                                        MAKE_MOVE_ID(move_white_pawn),
                                         board_attack_north);
                         }
                         break;
@@ -2863,7 +3381,7 @@ int generate_pawn_push_to(
                                 IS_LEGAL(from, to))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_black_pawn_rank7_to_6,
+                                        MAKE_MOVE_ID(move_black_pawn_rank7_to_6),
                                         board_attack_south);
                         }
                         break;
@@ -2872,7 +3390,7 @@ int generate_pawn_push_to(
                         if (bd->squares[from].piece == board_black_pawn) {
                                 if (IS_LEGAL(from, to)) {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_black_pawn,
+                                                MAKE_MOVE_ID(move_black_pawn),
                                                 board_attack_south);
                                 }
                         } else if (bd->squares[from].piece == board_empty) {
@@ -2881,7 +3399,7 @@ int generate_pawn_push_to(
                                         IS_LEGAL(from, to))
                                 {
                                         GENERATE_PAWN_MOVE(from, to,
-                                                move_black_pawn_rank7_to_5,
+                                                MAKE_MOVE_ID(move_black_pawn_rank7_to_5),
                                                 board_attack_south);
                                 }
                         } else {
@@ -2896,7 +3414,7 @@ int generate_pawn_push_to(
                                 IS_LEGAL(from, to))
                         {
                                 GENERATE_PAWN_MOVE(from, to,
-                                        move_black_pawn,
+                                        MAKE_MOVE_ID(move_black_pawn),
                                         board_attack_south);
                         }
                         break;
@@ -2922,10 +3440,11 @@ int generate_pawn_push_to(
  *  Generate legal en-passant moves.
  *  This is a helper function for generate_escapes and generate_regular.
  */
-static
+GENERATE_INLINE
 int generate_en_passant(
         struct board *bd,
-        union board_move moves_p[BOARD_MAX_MOVES])
+        union board_move moves_p[BOARD_MAX_MOVES],
+        int side)
 {
         int nr_moves = 0;
 
@@ -2934,11 +3453,13 @@ int generate_en_passant(
         /*
          *  First catch false hits due to lazy setting of the en_passant flag
          */
+        BOARD_STATS_COUNT(en_passant_tests, 1);
         if (bd->current->node_counter != bd->current->en_passant_node_counter) {
                 /*
                  *  The en_passant flag has expired and should have been reset.
                  *  Clear it now and leave.
                  */
+                BOARD_STATS_COUNT(en_passant_false_hits, 1);
                 bd->current->en_passant_lazy = 0;
                 return 0;
         }
@@ -2986,7 +3507,7 @@ int generate_en_passant(
          */
         if ((bd->current->active.attacks[to] & board_attack_pawn_east) != 0) {
 
-                if (bd->current->active.color == board_white) {
+                if (side == board_white) {
                         /*
                          *  White to move
                          */
@@ -3035,7 +3556,7 @@ int generate_en_passant(
                         }
 
                         if (pin_dirs == 0) {
-                                GENERATE_EP(from, to, enpassant_with_white_pawn);
+                                GENERATE_EP(from, to, MAKE_MOVE_ID(enpassant_with_white_pawn));
                         }
                 } else {
                         /*
@@ -3086,7 +3607,7 @@ int generate_en_passant(
                         }
 
                         if (pin_dirs == 0) {
-                                GENERATE_EP(from, to, enpassant_with_black_pawn);
+                                GENERATE_EP(from, to, MAKE_MOVE_ID(enpassant_with_black_pawn));
                         }
                 }
         }
@@ -3096,7 +3617,7 @@ int generate_en_passant(
          */
         if ((bd->current->active.attacks[to] & board_attack_pawn_west) != 0) {
 
-                if (bd->current->active.color == board_white) {
+                if (side == board_white) {
                         /*
                          *  White to move
                          */
@@ -3145,7 +3666,7 @@ int generate_en_passant(
                         }
 
                         if (pin_dirs == 0) {
-                                GENERATE_EP(from, to, enpassant_with_white_pawn);
+                                GENERATE_EP(from, to, MAKE_MOVE_ID(enpassant_with_white_pawn));
                         }
                 } else {
                         /*
@@ -3196,7 +3717,7 @@ int generate_en_passant(
                         }
 
                         if (pin_dirs == 0) {
-                                GENERATE_EP(from, to, enpassant_with_black_pawn);
+                                GENERATE_EP(from, to, MAKE_MOVE_ID(enpassant_with_black_pawn));
                         }
                 }
         }
@@ -3204,6 +3725,8 @@ int generate_en_passant(
         return nr_moves;
 }
 
+#if !defined(GENERATE_UNSCORED)
+
 /*----------------------------------------------------------------------+
  |      _is_legal                                                       |
  +----------------------------------------------------------------------*/
@@ -3252,6 +3775,96 @@ bool _is_legal(struct board *bd, int from, int to)
         return (sq != king);
 }
 
+/*----------------------------------------------------------------------+
+ |      Unscored generator                                              |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Tools that only enumerate positions never look at the prescores.
+ *  Instantiate the generator a second time, under other names, with
+ *  move macros that only store the move. The exchange evaluation and
+ *  butterfly lookups drop out. The move list itself stays the same.
+ */
+
+#define GENERATE_UNSCORED
+
+#undef GENERATE_STATS_UNSCORED
+#define GENERATE_STATS_UNSCORED 1
+
+#undef GENERATE_MOVE
+#define GENERATE_MOVE(from, to, move_maker) do{\
+        assert(BOARD_SQUARE_IS_VALID(from));\
+        assert(BOARD_SQUARE_IS_VALID(to));\
+\
+        moves_p[nr_moves].bm.prescore = 0;\
+        moves_p[nr_moves].bm.move = (short) MOVE(from, to);\
+        moves_p[nr_moves].bm.make = (move_maker);\
+        (nr_moves)++;\
+}while(0)
+
+#undef GENERATE_PAWN_MOVE
+#define GENERATE_PAWN_MOVE(from, to, move_maker, dir) GENERATE_MOVE(from, to, move_maker)
+
+#undef GENERATE_KING_MOVE
+#define GENERATE_KING_MOVE GENERATE_MOVE
+
+#undef GENERATE_KING_CAPTURE
+#define GENERATE_KING_CAPTURE GENERATE_MOVE
+
+#undef GENERATE_EP
+#define GENERATE_EP GENERATE_MOVE
+
+#define GENERATE_PROMOTION(from, to, side) do{\
+        assert(BOARD_SQUARE_IS_VALID(from));\
+        assert(BOARD_SQUARE_IS_VALID(to));\
+\
+        int _move = MOVE(from, to);\
+        moves_p[nr_moves].bm.prescore = 0;\
+        moves_p[nr_moves].bm.move = (short) (_move ^ XOR_PROM_QUEEN);\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_##side##_queen);\
+        (nr_moves)++;\
+        moves_p[nr_moves].bm.prescore = 0;\
+        moves_p[nr_moves].bm.move = (short) (_move ^ XOR_PROM_ROOK);\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_##side##_rook);\
+        (nr_moves)++;\
+        moves_p[nr_moves].bm.prescore = 0;\
+        moves_p[nr_moves].bm.move = (short) (_move ^ XOR_PROM_BISHOP);\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_##side##_bishop);\
+        (nr_moves)++;\
+        moves_p[nr_moves].bm.prescore = 0;\
+        moves_p[nr_moves].bm.move = (short) (_move ^ XOR_PROM_KNIGHT);\
+        moves_p[nr_moves].bm.make = MAKE_MOVE_ID(promote_##side##_knight);\
+        (nr_moves)++;\
+}while(0)
+
+#undef GENERATE_WHITE_PROMOTION
+#define GENERATE_WHITE_PROMOTION(from, to) GENERATE_PROMOTION(from, to, white)
+
+#undef GENERATE_BLACK_PROMOTION
+#define GENERATE_BLACK_PROMOTION(from, to) GENERATE_PROMOTION(from, to, black)
+
+#define board_generate_all_moves board_generate_all_moves_unscored
+#define board_generate_captures_and_promotions board_generate_captures_and_promotions_unscored
+#define board_generate_regular_moves board_generate_regular_moves_unscored
+#define board_generate_escapes board_generate_escapes_unscored
+#define generate_all_moves generate_all_moves_unscored
+#define generate_captures_and_promotions generate_captures_and_promotions_unscored
+#define generate_escapes generate_escapes_unscored
+#define generate_moves_to_square generate_moves_to_square_unscored
+#define generate_captures_to_square generate_captures_to_square_unscored
+#define generate_pawn_push_to generate_pawn_push_to_unscored
+#define generate_en_passant generate_en_passant_unscored
+#define generate_captures_to_square_white generate_captures_to_square_unscored_white
+#define generate_captures_to_square_black generate_captures_to_square_unscored_black
+#define generate_pawn_push_to_white generate_pawn_push_to_unscored_white
+#define generate_pawn_push_to_black generate_pawn_push_to_unscored_black
+#define generate_en_passant_white generate_en_passant_unscored_white
+#define generate_en_passant_black generate_en_passant_unscored_black
+
+#include "generate.c"
+
+#endif // !defined(GENERATE_UNSCORED)
+
 /*----------------------------------------------------------------------+
  |                                                                      |
  +----------------------------------------------------------------------*/
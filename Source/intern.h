@@ -47,6 +47,49 @@
 typedef
 void make_move_fn(struct board *bd, int from, int to);
 
+/*
+ *  All move makers. The generator stores the index of the move maker
+ *  in move_p->make instead of a pointer, to keep board_move small.
+ *  board_make_move looks it up in make_move_table.
+ */
+#define MAKE_MOVE_FUNCTIONS(X)\
+        X(move_white_king)                      X(move_black_king)\
+        X(move_white_king_castle)               X(move_black_king_castle)\
+        X(move_white_queen)                     X(move_black_queen)\
+        X(move_white_rook)                      X(move_black_rook)\
+        X(move_white_rook_castle)               X(move_black_rook_castle)\
+        X(move_white_bishop)                    X(move_black_bishop)\
+        X(move_white_knight)                    X(move_black_knight)\
+        X(move_white_pawn_rank2_to_3)           X(move_black_pawn_rank7_to_6)\
+        X(move_white_pawn_rank2_to_4)           X(move_black_pawn_rank7_to_5)\
+        X(move_white_pawn)                      X(move_black_pawn)\
+        X(capture_with_king)\
+        X(capture_with_white_king_castle)       X(capture_with_black_king_castle)\
+        X(capture_with_queen)\
+        X(capture_with_rook)\
+        X(capture_with_white_rook_castle)       X(capture_with_black_rook_castle)\
+        X(capture_with_bishop)\
+        X(capture_with_knight)\
+        X(capture_with_white_pawn)              X(capture_with_black_pawn)\
+        X(castle_white_king_side)               X(castle_black_king_side)\
+        X(castle_white_queen_side)              X(castle_black_queen_side)\
+        X(enpassant_with_white_pawn)            X(enpassant_with_black_pawn)\
+        X(promote_white_queen)                  X(promote_black_queen)\
+        X(promote_white_rook)                   X(promote_black_rook)\
+        X(promote_white_bishop)                 X(promote_black_bishop)\
+        X(promote_white_knight)                 X(promote_black_knight)
+
+#define MAKE_MOVE_ID(fn) make_move_id_##fn
+
+enum make_move_id {
+        #define X(fn) MAKE_MOVE_ID(fn),
+        MAKE_MOVE_FUNCTIONS(X)
+        #undef X
+        make_move_id_nr
+};
+
+extern make_move_fn * const make_move_table[make_move_id_nr];
+
 /*
  *  Null move definition.
  *  Should not be 0 because that better means 'no move'.
@@ -127,7 +170,7 @@ enum zobrist_piece_type {
 #define ZOBRIST_PIECE_TYPES 12
 };
 
-const unsigned long long data_zobrist[ZOBRIST_PIECE_TYPES][BOARD_SIZE];
+extern const unsigned long long data_zobrist[ZOBRIST_PIECE_TYPES][BOARD_SIZE];
 
 /*
  *  Hash castling rooks as a 'king', so that the castling
@@ -136,12 +179,26 @@ const unsigned long long data_zobrist[ZOBRIST_PIECE_TYPES][BOARD_SIZE];
 #define zobrist_white_rook_castle zobrist_white_pawn
 #define zobrist_black_rook_castle zobrist_black_pawn
 
+/*
+ *  A capturable en passant square is hashed with the white pawn numbers
+ *  of the 8th rank, one per file. Pawns can never appear there.
+ */
+#define ZOBRIST_EN_PASSANT(file) \
+        data_zobrist[zobrist_white_pawn][BOARD_SQUARE(file, BOARD_RANK_8)]
+
 /*----------------------------------------------------------------------*/
 
 /*
  *  Material keys
  */
-const unsigned long long data_material_key[BOARD_PIECE_TYPES];
+extern const unsigned long long data_material_key[BOARD_PIECE_TYPES];
+
+/*----------------------------------------------------------------------*/
+
+/*
+ *  Move makers update the hashes and material key only if this is true
+ */
+#define KEYS_ENABLED(bd) (!(bd)->lazy_keys)
 
 /*----------------------------------------------------------------------*/
 
@@ -207,20 +264,37 @@ enum {
 
 /*----------------------------------------------------------------------*/
 
-const int data_bishop_diagonals[BOARD_SIZE];
+extern const int data_bishop_diagonals[BOARD_SIZE];
 
 /*----------------------------------------------------------------------*/
 
 /*
- *  Tables and definitions for upcoming repetition detection
+ *  Cuckoo table of the reversible moves of each color, for upcoming
+ *  repetition detection (see repetition.c)
  */
 
 #define DATA_CUCKOO_MOVE_HASH1(h) ((int) (((h) >> 32) & 0x0fff))
 #define DATA_CUCKOO_MOVE_HASH2(h) ((int) (((h) >> 48) & 0x0fff))
 #define DATA_CUCKOO_MOVE_KEY(h) (((unsigned long) h) & 0xffffffffUL)
 
-const unsigned long data_cuckoo_move_keys[2][0x1000];
-const char data_cuckoo_squares[2][0x1000][2]; // from-to
+extern const unsigned long data_cuckoo_move_keys[2][0x1000];
+extern const char data_cuckoo_squares[2][0x1000][2]; // from-to
+
+/*----------------------------------------------------------------------*/
+
+/*
+ *  Precomputed static exchange evaluation (see exchange.c)
+ *
+ *  data_exchange_list[] maps a 12-bit piece list to a compact index,
+ *  or -1 if it holds more pieces than a side has without promotions:
+ *  2 pawns, 3 minors, 2 rooks and 2 royals. The table is then indexed
+ *  by the defenders' last rank bit, their list, the attackers' upfront
+ *  and last rank bits, and their list. Entries are in EXCHANGE_UNIT.
+ */
+#define DATA_EXCHANGE_LISTS (3*4*3*3)
+
+extern const signed char data_exchange_list[0x1000];
+extern const unsigned char data_exchange_table[2][DATA_EXCHANGE_LISTS][8][DATA_EXCHANGE_LISTS];
 
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
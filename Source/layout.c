@@ -60,6 +60,7 @@
  +----------------------------------------------------------------------*/
 
 #define ERR_INVALID_EPD "Invalid chess position EPD string"
+#define ERR_INVALID_BINARY "Invalid binary position record"
 
 #define WHITE_HAS_KING_SIDE_CASTLING_CONFIG(bd) (\
         ( (bd->squares[E1].piece == board_white_king) ||\
@@ -101,6 +102,8 @@
  |      Data                                                            |
  +----------------------------------------------------------------------*/
 
+_Thread_local struct board_stats board_stats;
+
 const signed char board_vector_step[] = {
         [board_attack_north]     = BOARD_VECTOR_NORTH,
         [board_attack_northeast] = BOARD_VECTOR_NORTHEAST,
@@ -196,10 +199,10 @@ err_t calc_material_key(
 /*----------------------------------------------------------------------*/
 
 static
-int cmp_piece(const void *ap, const void *bp);
+err_t update_board_after_edit(struct board *bd, int side_to_move);
 
 static
-err_t update_board_after_edit(struct board *bd, int side_to_move);
+void clear_stack(struct board *bd);
 
 /*----------------------------------------------------------------------+
  |      board_module_init                                               |
@@ -318,9 +321,11 @@ err_t board_check(struct board *bd)
         err = calc_material_key(bd, &material_key);
         check(err);
 
-        assert(board_hash_lazy == bd->current->board_hash_lazy);
-        assert(pawn_king_hash == bd->current->pawn_king_hash);
-        assert(material_key == bd->current->material_key);
+        if (!bd->lazy_keys) {
+                assert(board_hash_lazy == bd->current->board_hash_lazy);
+                assert(pawn_king_hash == bd->current->pawn_king_hash);
+                assert(material_key == bd->current->material_key);
+        }
 
         /*
          *  Check the sanity of halfmove_clock
@@ -410,6 +415,10 @@ err_t board_check_side(
         }
         assert(bd->current->active.last_rank_pawns == ref.last_rank_pawns);
         assert(bd->current->active.bishop_diagonals == ref.bishop_diagonals);
+#if defined(BOARD_BITBOARDS)
+        assert(bd->current->active.occupied == ref.occupied);
+        assert(bd->current->active.attacked == ref.attacked);
+#endif
 
         // passive
         err = calc_struct_board_side(bd, &ref, !bd->current->active.color);
@@ -419,6 +428,10 @@ err_t board_check_side(
         }
         assert(bd->current->passive.last_rank_pawns == ref.last_rank_pawns);
         assert(bd->current->passive.bishop_diagonals == ref.bishop_diagonals);
+#if defined(BOARD_BITBOARDS)
+        assert(bd->current->passive.occupied == ref.occupied);
+        assert(bd->current->passive.attacked == ref.attacked);
+#endif
 
 cleanup:
         return err;
@@ -569,8 +582,7 @@ err_t board_setup_raw(struct board *bd, const char *epd)
         int rank = BOARD_RANK_8;
         int ix = 0;
 
-        memset(bd->stack, 0, sizeof(bd->stack));
-        bd->current = &bd->stack[2]; /* keep two frames unused */
+        clear_stack(bd);
 
         int side_to_move = -1;
 
@@ -829,6 +841,151 @@ cleanup:
         return err;
 }
 
+/*----------------------------------------------------------------------+
+ |      board_setup_binary                                              |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Setup position from a binary record (see board_binary_record)
+ */
+err_t board_setup_binary(struct board *bd, const struct board_binary *record)
+{
+        err_t err = OK;
+
+        static const signed char code_to_piece[16] = {
+                [board_binary_king]           = board_white_king,
+                [board_binary_queen]          = board_white_queen,
+                [board_binary_rook]           = board_white_rook,
+                [board_binary_bishop]         = board_white_bishop_light,
+                [board_binary_knight]         = board_white_knight,
+                [board_binary_pawn]           = board_white_pawn,
+                [board_binary_rook_castle]    = board_white_rook,
+                [board_binary_pawn_en_passant] = board_white_pawn,
+                [board_binary_black + board_binary_king]           = board_black_king,
+                [board_binary_black + board_binary_queen]          = board_black_queen,
+                [board_binary_black + board_binary_rook]           = board_black_rook,
+                [board_binary_black + board_binary_bishop]         = board_black_bishop_light,
+                [board_binary_black + board_binary_knight]         = board_black_knight,
+                [board_binary_black + board_binary_pawn]           = board_black_pawn,
+                [board_binary_black + board_binary_rook_castle]    = board_black_rook,
+                [board_binary_black + board_binary_pawn_en_passant] = board_black_pawn,
+        };
+
+        clear_stack(bd);
+
+        int side_to_move = record->side_to_move;
+        if ((side_to_move != board_white) && (side_to_move != board_black)) {
+                xRaise(ERR_INVALID_BINARY);
+        }
+
+        /*
+         *  Pieces
+         */
+        int castle_rooks[4];
+        int nr_castle_rooks = 0;
+        int ep_pawn = -1;
+        int n = 0;
+
+        for (int sq=0; sq<BOARD_SIZE; sq++) {
+                bd->squares[sq].index = 0;
+                bd->squares[sq].piece = board_empty;
+
+                if (((record->occupied[sq >> 3] >> (sq & 7)) & 1) == 0) {
+                        continue;
+                }
+                if (n >= 2 * (int) sizeof(record->pieces)) {
+                        xRaise(ERR_INVALID_BINARY);
+                }
+
+                int code = (record->pieces[n >> 1] >> ((n & 1) * 4)) & 0xf;
+                n++;
+
+                int piece = code_to_piece[code];
+                switch (piece) {
+                case board_white_bishop_light:
+                case board_black_bishop_light:
+                        if (!BOARD_SQUARE_IS_LIGHT(sq)) {
+                                piece += board_white_bishop_dark - board_white_bishop_light;
+                        }
+                        break;
+                case board_white_pawn:
+                        if (BOARD_RANK(sq) == BOARD_RANK_2) piece = board_white_pawn_rank2;
+                        if (BOARD_RANK(sq) == BOARD_RANK_7) piece = board_white_pawn_rank7;
+                        break;
+                case board_black_pawn:
+                        if (BOARD_RANK(sq) == BOARD_RANK_7) piece = board_black_pawn_rank7;
+                        if (BOARD_RANK(sq) == BOARD_RANK_2) piece = board_black_pawn_rank2;
+                        break;
+                }
+                bd->squares[sq].piece = piece;
+
+                switch (code & ~board_binary_black) {
+                case board_binary_rook_castle:
+                        if (nr_castle_rooks == 4) xRaise(ERR_INVALID_BINARY);
+                        castle_rooks[nr_castle_rooks++] = sq;
+                        break;
+                case board_binary_pawn_en_passant:
+                        if (ep_pawn >= 0) xRaise(ERR_INVALID_BINARY);
+                        ep_pawn = sq;
+                        break;
+                }
+        }
+
+        /*
+         *  Castling rights
+         */
+        for (int i=0; i<nr_castle_rooks; i++) {
+                switch (castle_rooks[i]) {
+                case H1:
+                        if (!WHITE_HAS_KING_SIDE_CASTLING_CONFIG(bd)) xRaise(ERR_INVALID_BINARY);
+                        bd->squares[E1].piece = board_white_king_castle;
+                        bd->squares[H1].piece = board_white_rook_castle;
+                        break;
+                case A1:
+                        if (!WHITE_HAS_QUEEN_SIDE_CASTLING_CONFIG(bd)) xRaise(ERR_INVALID_BINARY);
+                        bd->squares[E1].piece = board_white_king_castle;
+                        bd->squares[A1].piece = board_white_rook_castle;
+                        break;
+                case H8:
+                        if (!BLACK_HAS_KING_SIDE_CASTLING_CONFIG(bd)) xRaise(ERR_INVALID_BINARY);
+                        bd->squares[E8].piece = board_black_king_castle;
+                        bd->squares[H8].piece = board_black_rook_castle;
+                        break;
+                case A8:
+                        if (!BLACK_HAS_QUEEN_SIDE_CASTLING_CONFIG(bd)) xRaise(ERR_INVALID_BINARY);
+                        bd->squares[E8].piece = board_black_king_castle;
+                        bd->squares[A8].piece = board_black_rook_castle;
+                        break;
+                default:
+                        xRaise(ERR_INVALID_BINARY);
+                }
+        }
+
+        /*
+         *  En-passant status (verified in update_board_after_edit)
+         */
+        bd->current->en_passant_lazy = 0;
+        if (ep_pawn >= 0) {
+                if (BOARD_PIECE_COLOR(bd->squares[ep_pawn].piece) == side_to_move) {
+                        xRaise(ERR_INVALID_BINARY);
+                }
+                bd->current->en_passant_lazy = (side_to_move == board_white) ?
+                        ep_pawn + BOARD_VECTOR_NORTH :
+                        ep_pawn + BOARD_VECTOR_SOUTH;
+                bd->current->en_passant_node_counter = bd->current->node_counter;
+        }
+
+        bd->game_halfmove_clock_offset = 0;
+        bd->current->halfmove_clock = 0;
+        bd->game_fullmove_number = 1;
+
+        err = update_board_after_edit(bd, side_to_move);
+        check(err);
+
+cleanup:
+        return err;
+}
+
 /*----------------------------------------------------------------------+
  |      board_setup_square                                              |
  +----------------------------------------------------------------------*/
@@ -966,6 +1123,226 @@ cleanup:
         return err;
 }
 
+/*----------------------------------------------------------------------+
+ |      board_snapshot                                                  |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  The current frame has everything that setup would calculate:
+ *  attack tables, piece lists, keys and en passant status
+ */
+void board_snapshot(const struct board *bd, struct board_snapshot *snapshot)
+{
+        memcpy(snapshot->squares, bd->squares, sizeof snapshot->squares);
+        snapshot->frame = *bd->current;
+        snapshot->game_fullmove_number = bd->game_fullmove_number;
+        snapshot->game_halfmove_clock_offset = bd->game_halfmove_clock_offset;
+        snapshot->lazy_keys = bd->lazy_keys;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_restore                                                   |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Setup a position from a snapshot. The frame keeps its node counter,
+ *  so that the en passant status stays valid as it was.
+ */
+err_t board_restore(struct board *bd, const struct board_snapshot *snapshot)
+{
+        err_t err = OK;
+
+        clear_stack(bd);
+
+        memcpy(bd->squares, snapshot->squares, sizeof bd->squares);
+        *bd->current = snapshot->frame;
+        bd->current->undo_len = 0;
+
+        /*
+         *  Frames -1 and -2 are empty now, so the clock can't reach back
+         */
+        bd->game_halfmove_clock_offset = snapshot->game_halfmove_clock_offset +
+                snapshot->frame.halfmove_clock;
+        bd->current->halfmove_clock = 0;
+        bd->game_fullmove_number = snapshot->game_fullmove_number;
+
+        if (snapshot->lazy_keys && !bd->lazy_keys) {
+                err = board_update_keys(bd);
+                check(err);
+        }
+
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_stats_collect                                             |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  All fields are counters of the same type, so add them as an array
+ */
+void board_stats_add(struct board_stats *total, const struct board_stats *stats)
+{
+        long long *to = (long long *) total;
+        const long long *from = (const long long *) stats;
+
+        for (int i=0; i<(int) (sizeof(*total) / sizeof(*to)); i++) {
+                to[i] += from[i];
+        }
+}
+
+void board_stats_collect(struct board_stats *total)
+{
+        board_stats_add(total, &board_stats);
+        memset(&board_stats, 0, sizeof(board_stats));
+}
+
+/*----------------------------------------------------------------------+
+ |      board_en_passant_square                                         |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Get the en passant target square, or 0 if there is none.
+ *
+ *  The square is only reported when the double pushed pawn can actually
+ *  be captured by a pawn. This is the same rule the FEN string uses, so
+ *  that transposing positions all have the same en passant status.
+ *  (The capture itself can still be illegal in rare cases.)
+ */
+int board_en_passant_square(const struct board *bd)
+{
+        int ep_square = bd->current->en_passant_lazy;
+
+        if (ep_square == 0) {
+                return 0;
+        }
+        if (bd->current->node_counter != bd->current->en_passant_node_counter) {
+                return 0;
+        }
+
+        if (BOARD_RANK(ep_square) == BOARD_RANK_3) {
+                if ((BOARD_FILE(ep_square) != BOARD_FILE_A) &&
+                    (bd->squares[ep_square + BOARD_VECTOR_NORTHWEST].piece == board_black_pawn)
+                ) {
+                        return ep_square;
+                }
+                if ((BOARD_FILE(ep_square) != BOARD_FILE_H) &&
+                    (bd->squares[ep_square + BOARD_VECTOR_NORTHEAST].piece == board_black_pawn)
+                ) {
+                        return ep_square;
+                }
+        }
+        if (BOARD_RANK(ep_square) == BOARD_RANK_6) {
+                if ((BOARD_FILE(ep_square) != BOARD_FILE_A) &&
+                    (bd->squares[ep_square + BOARD_VECTOR_SOUTHWEST].piece == board_white_pawn)
+                ) {
+                        return ep_square;
+                }
+                if ((BOARD_FILE(ep_square) != BOARD_FILE_H) &&
+                    (bd->squares[ep_square + BOARD_VECTOR_SOUTHEAST].piece == board_white_pawn)
+                ) {
+                        return ep_square;
+                }
+        }
+
+        return 0;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_hash                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Get the full position hash: the lazy hash plus the en passant status.
+ *  Side to move and castling status are part of the lazy hash already.
+ */
+unsigned long long board_hash(const struct board *bd)
+{
+        unsigned long long hash = bd->current->board_hash_lazy;
+
+        int ep_square = board_en_passant_square(bd);
+        if (ep_square != 0) {
+                hash ^= ZOBRIST_EN_PASSANT(BOARD_FILE(ep_square));
+        }
+
+        return hash;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_set_lazy_keys                                             |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Enable or disable the maintenance of keys while making moves.
+ *  Leaving the lazy mode brings the keys of the current position up
+ *  to date. Retracting moves then still gives stale keys.
+ */
+void board_set_lazy_keys(struct board *bd, bool lazy_keys)
+{
+        bool was_lazy = bd->lazy_keys;
+        bd->lazy_keys = lazy_keys;
+
+        if (was_lazy && !lazy_keys) {
+                err_t err = board_update_keys(bd);
+                if (err != OK) errAbort(err);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      board_set_max_depth                                             |
+ +----------------------------------------------------------------------*/
+
+void board_set_max_depth(struct board *bd, int max_depth)
+{
+        assert(max_depth >= 0);
+        bd->max_depth = max_depth;
+}
+
+/*----------------------------------------------------------------------+
+ |      clear_stack                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Clear the stack frames for setup, keeping two frames unused
+ *  below the root. Making max_depth moves needs as many frames
+ *  above it, plus one.
+ */
+static
+void clear_stack(struct board *bd)
+{
+        int nr_frames = arrayLen(bd->stack);
+
+        if ((bd->max_depth > 0) && (2 + bd->max_depth + 1 < nr_frames)) {
+                nr_frames = 2 + bd->max_depth + 1;
+        }
+        memset(bd->stack, 0, nr_frames * sizeof(bd->stack[0]));
+        bd->current = &bd->stack[2];
+}
+
+/*----------------------------------------------------------------------+
+ |      board_update_keys                                               |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Recalculate the hashes and material key of the current position
+ */
+err_t board_update_keys(struct board *bd)
+{
+        err_t err = OK;
+
+        err = calc_zobrist_hashes(bd,
+                &bd->current->board_hash_lazy,
+                &bd->current->pawn_king_hash);
+        check(err);
+
+        err = calc_material_key(bd, &bd->current->material_key);
+        check(err);
+
+cleanup:
+        return err;
+}
+
 /*----------------------------------------------------------------------+
  |      update_board_after_edit                                         |
  +----------------------------------------------------------------------*/
@@ -1117,20 +1494,14 @@ err_t update_board_after_edit(struct board *bd, int side_to_move)
         }
 
         /*------------------------------------------------------+
-         |      Calculate hashes                                |
+         |      Calculate hashes and material key               |
          +------------------------------------------------------*/
 
-        err = calc_zobrist_hashes(bd,
-                &bd->current->board_hash_lazy,
-                &bd->current->pawn_king_hash);
-        check(err);
-
-        /*------------------------------------------------------+
-         |      Calculate material key                          |
-         +------------------------------------------------------*/
-
-        err = calc_material_key(bd, &bd->current->material_key);
-        check(err);
+        // in lazy mode they wait for board_update_keys
+        if (!bd->lazy_keys) {
+                err = board_update_keys(bd);
+                check(err);
+        }
 
         /*------------------------------------------------------+
          |      Test for consistency                            |
@@ -1170,12 +1541,20 @@ err_t calc_struct_board_side(
 
         side->bishop_diagonals = 0;
 
+#if defined(BOARD_BITBOARDS)
+        side->occupied = 0;
+#endif
+
         for (int sq=0; sq<BOARD_SIZE; sq++) {
                 int piece = bd->squares[sq].piece;
                 if (BOARD_PIECE_COLOR(piece) != color) {
                         continue;
                 }
 
+#if defined(BOARD_BITBOARDS)
+                side->occupied |= bit(sq);
+#endif
+
                 // append to piece list
                 if (nr_pieces > BOARD_SIDE_MAX_PIECES) {
                         xRaise("Too many pieces of the same color");
@@ -1264,8 +1643,16 @@ err_t calc_struct_board_side(
         err = calc_attacks(bd, side, color);
         check(err);
 
-        // sort piece list (king, knights, others)
-        qsort(pieces, nr_pieces, sizeof pieces[0], cmp_piece);
+        // sort piece list (king, knights, others). The pieces were found
+        // in square order, so a stable sort by piece makes it deterministic
+        for (int i=1; i<nr_pieces; i++) {
+                struct board_square const *piece = pieces[i];
+                int j = i;
+                for (; (j > 0) && (pieces[j-1]->piece > piece->piece); j--) {
+                        pieces[j] = pieces[j-1];
+                }
+                pieces[j] = piece;
+        }
 
         for (int i=0; i<nr_pieces; i++) {
                 side->pieces[i] = pieces[i] - &bd->squares[0];
@@ -1293,6 +1680,9 @@ err_t calc_attacks(
 
         // clear all attacks
         memset(side->attacks, 0, sizeof side->attacks);
+#if defined(BOARD_BITBOARDS)
+        side->attacked = 0;
+#endif
 
         // loop over board, not over the piece list, because piece list may not
         // be initialized
@@ -1543,31 +1933,6 @@ err_t calc_material_key(
         return err;
 }
 
-/*----------------------------------------------------------------------+
- |      cmp_piece                                                       |
- +----------------------------------------------------------------------*/
-
-/*
- *  Comparison function for piece list ordering
- *  (doesn't have to be deterministic)
- */
-static
-int cmp_piece(const void *ap, const void *bp)
-{
-        struct board_square * const *a = ap;
-        struct board_square * const *b = bp;
-
-        if ((*a)->piece < (*b)->piece) return -1;
-        if ((*a)->piece > (*b)->piece) return 1;
-
-        // Make the sorting deterministic
-        if (*a < *b) return -1;
-        if (*a > *b) return 1;
-
-        assert(false); // qsort() shouldn't come as far as this
-        return 0;
-}
-
 /*----------------------------------------------------------------------+
  |                                                                      |
  +----------------------------------------------------------------------*/
@@ -20,6 +20,7 @@
  *      2009-09-21 (marcelk) Added pawn attacks into data_sq2sq[].
  *      2013-01-23 (marcelk) Cuckoo table with zobrist hashes of reversible moves
  *      2013-03-10 (marcelk) Added cuckoo squares for faster legality test of cuckoo moves
+ *      Precomputed static exchange evaluation table
  */
 
 /*----------------------------------------------------------------------+
@@ -55,6 +56,7 @@
  *  Other includes
  */
 #include "board.h"
+#include "exchange.h"
 #include "intern.h"
 
 /*----------------------------------------------------------------------+
@@ -64,6 +66,9 @@
 static
 int compare_reversible_move(const void *ap, const void *bp);
 
+static
+int exchange_compute(int defenders, int attackers);
+
 struct cuckoo_move {
         unsigned long long move_hash;
         char squares[2];
@@ -701,6 +706,70 @@ int main(void)
 
         printf("\n};\n\n");
 
+        /*------------------------------------------------------+
+         |      Static exchange evaluation                      |
+         +------------------------------------------------------*/
+
+        signed char exchange_list[0x1000];
+        int exchange_lists[DATA_EXCHANGE_LISTS];
+        int nr_lists = 0;
+
+        memset(exchange_list, -1, sizeof exchange_list);
+
+        for (int royal=0; royal<=2; royal++) {
+                for (int rook=0; rook<=2; rook++) {
+                        for (int minor=0; minor<=3; minor++) {
+                                for (int pawn=0; pawn<=2; pawn++) {
+                                        int list =
+                                                pawn * EXCHANGE_LIST_PAWN +
+                                                minor * EXCHANGE_LIST_MINOR +
+                                                rook * EXCHANGE_LIST_ROOK +
+                                                royal * EXCHANGE_LIST_ROYAL;
+                                        exchange_list[list] = nr_lists;
+                                        exchange_lists[nr_lists++] = list;
+                                }
+                        }
+                }
+        }
+        assert(nr_lists == DATA_EXCHANGE_LISTS);
+
+        printf("const signed char data_exchange_list[0x1000] = {");
+
+        for (int list=0; list<0x1000; list++) {
+                printf("%s%3d,", (list&15)?"":"\n ", exchange_list[list]);
+        }
+
+        printf("\n};\n\n");
+
+        printf("const unsigned char data_exchange_table[2][DATA_EXCHANGE_LISTS][8][DATA_EXCHANGE_LISTS] = {\n");
+
+        for (int dl=0; dl<2; dl++) {
+                printf(" {\n");
+                for (int d=0; d<DATA_EXCHANGE_LISTS; d++) {
+                        printf("  {\n");
+                        for (int ah=0; ah<8; ah++) {
+                                printf("   {");
+                                for (int a=0; a<DATA_EXCHANGE_LISTS; a++) {
+                                        int defenders = (dl << 12) | exchange_lists[d];
+                                        int attackers = (ah << 12) | exchange_lists[a];
+                                        int value = 0;
+
+                                        // Both on the last rank can't happen
+                                        if (defenders != 0 && (defenders & attackers & EXCHANGE_LAST_RANK) == 0) {
+                                                value = exchange_compute(defenders, attackers);
+                                        }
+                                        assert(value % EXCHANGE_UNIT == 0);
+                                        printf("%s%2d,", (a%24)?"":"\n    ", value / EXCHANGE_UNIT);
+                                }
+                                printf("\n   },\n");
+                        }
+                        printf("  },\n");
+                }
+                printf(" },\n");
+        }
+
+        printf("};\n\n");
+
         /*------------------------------------------------------+
          |                                                      |
          +------------------------------------------------------*/
@@ -708,6 +777,75 @@ int main(void)
         return 0;
 }
 
+/*
+ *  Static exchange evaluation of two piece lists, as described in
+ *  exchange.c. This is the reference for data_exchange_table[], and
+ *  must give the same results as the run time fallback there.
+ */
+static
+int exchange_compute(int defenders, int attackers)
+{
+        assert(defenders != 0);
+        assert((defenders & attackers & EXCHANGE_LAST_RANK) == 0);
+
+        static const int victim_value[4] = {
+                1 * EXCHANGE_UNIT,        // pawn
+                3 * EXCHANGE_UNIT,        // minor (bishop or knight)
+                5 * EXCHANGE_UNIT,        // rook
+                9 * EXCHANGE_UNIT,        // royal (king or queen)
+        };
+        int result = victim_value[ attackers >> 13 ];
+
+        if (defenders == EXCHANGE_LAST_RANK) {
+                return 0;
+        }
+
+        /*
+         *  Select next capturer: the least valued piece goes upfront
+         */
+        int pawns = (defenders & 0x0fff) % (EXCHANGE_LIST_MINOR / EXCHANGE_LIST_PAWN);
+
+        if ((defenders & EXCHANGE_LAST_RANK) != 0 && pawns > 0) {
+                result += 8 * EXCHANGE_UNIT;
+                defenders += (3 << 13) - EXCHANGE_LIST_PAWN;
+                if (pawns == 1) {
+                        defenders -= EXCHANGE_LAST_RANK;
+                }
+        } else {
+                defenders &= ~EXCHANGE_LAST_RANK;
+                int d = defenders;
+                if (d % (EXCHANGE_LIST_MINOR / EXCHANGE_LIST_PAWN) != 0) {
+                        defenders += (0 << 13) - EXCHANGE_LIST_PAWN;
+                } else if ((d /= EXCHANGE_LIST_MINOR) % (EXCHANGE_LIST_ROOK / EXCHANGE_LIST_MINOR) != 0) {
+                        defenders += (1 << 13) - EXCHANGE_LIST_MINOR;
+                } else if ((d / (EXCHANGE_LIST_ROOK / EXCHANGE_LIST_MINOR)) % (EXCHANGE_LIST_ROYAL / EXCHANGE_LIST_ROOK) != 0) {
+                        defenders += (2 << 13) - EXCHANGE_LIST_ROOK;
+                } else {
+                        defenders += (3 << 13) - EXCHANGE_LIST_ROYAL;
+                }
+        }
+
+        /*
+         *  Recursive evaluation, with standing pat if that is better
+         */
+        attackers &= 0x1fff; /* remove the upfront piece */
+        if (attackers != 0) {
+                result -= exchange_compute(attackers, defenders);
+                if (result < 0) {
+                        result = 0;
+                }
+        }
+
+        /*
+         *  Clip at +14 so that the SEE result always fits in 4 bits
+         */
+        if (result > 14 * EXCHANGE_UNIT) {
+                result = 14 * EXCHANGE_UNIT;
+        }
+
+        return result;
+}
+
 /*
  *  Function to compare reversible moves for qsort()
  */
@@ -48,6 +48,10 @@
  *  Other includes
  */
 #include "attack.h"
+#include "capture.h"
+#include "castle.h"
+#include "enpassant.h"
+#include "promote.h"
 
 /*----------------------------------------------------------------------+
  |      Definitions                                                     |
@@ -57,6 +61,15 @@
  |      Data                                                            |
  +----------------------------------------------------------------------*/
 
+/*
+ *  Move makers by make_move_id, for board_make_move
+ */
+make_move_fn * const make_move_table[make_move_id_nr] = {
+        #define X(fn) [MAKE_MOVE_ID(fn)] = fn,
+        MAKE_MOVE_FUNCTIONS(X)
+        #undef X
+};
+
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
  +----------------------------------------------------------------------*/
@@ -111,7 +124,8 @@ void board_make_move(struct board *bd, const union board_move *move)
         int to = MOVE_TO(move->bm.move);
         assert(BOARD_SQUARE_IS_VALID(to));
 
-        make_move_fn* make = (make_move_fn*) move->bm.make;
+        assert(move->bm.make < make_move_id_nr);
+        make_move_fn *make = make_move_table[move->bm.make];
 
         /*
          *  Undo information (preliminary)
@@ -127,6 +141,22 @@ void board_make_move(struct board *bd, const union board_move *move)
          */
         make(bd, from, to);
 
+#if defined(BOARD_BITBOARDS)
+        /*
+         *  The undo list names every square that changed
+         */
+        for (int i=0; i<frame->undo_len; i++) {
+                int sq = frame->undo[i].square;
+                int piece = bd->squares[sq].piece;
+                frame->active.occupied &= ~bit(sq);
+                frame->passive.occupied &= ~bit(sq);
+                if (BOARD_PIECE_COLOR(piece) == frame->active.color)
+                        frame->active.occupied |= bit(sq);
+                else if (piece != board_empty)
+                        frame->passive.occupied |= bit(sq);
+        }
+#endif
+
         /*
          *  Confirm that the move is indeed legal
          */
@@ -159,6 +189,7 @@ void board_undo_move(struct board *bd)
 
         assert(undo_len >= 2);
         assert(undo_len <= BOARD_UNDO_LEN_MAX);
+        BOARD_STATS_COUNT(undo_length[undo_len], 1);
 
         bd->squares[ frame->undo[0].square ] = frame->undo[0].piece;
         bd->squares[ frame->undo[1].square ] = frame->undo[1].piece;
@@ -281,8 +312,10 @@ void move_white_king_castle(struct board *bd, int from, int to)
                 delta_hash ^=
                         data_zobrist[zobrist_white_rook][A1] ^
                         data_zobrist[zobrist_white_rook_castle][A1];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][A1];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][A1];
+                }
         }
 
         if (bd->squares[H1].piece == board_white_rook_castle) {
@@ -291,8 +324,10 @@ void move_white_king_castle(struct board *bd, int from, int to)
                 delta_hash ^=
                         data_zobrist[zobrist_white_rook][H1] ^
                         data_zobrist[zobrist_white_rook_castle][H1];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_white_rook_castle][H1];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_white_rook_castle][H1];
+                }
         }
 
         /*
@@ -300,7 +335,9 @@ void move_white_king_castle(struct board *bd, int from, int to)
          */
         move_white_king(bd, from, to);
 
-        bd->current->board_hash_lazy ^= delta_hash; // must apply delta_hash AFTER because move function sets it
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= delta_hash; // must apply delta_hash AFTER because move function sets it
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -323,8 +360,10 @@ void move_black_king_castle(struct board *bd, int from, int to)
                 delta_hash ^=
                         data_zobrist[zobrist_black_rook][A8] ^
                         data_zobrist[zobrist_black_rook_castle][A8];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][A8];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][A8];
+                }
         }
 
         if (bd->squares[H8].piece == board_black_rook_castle) {
@@ -333,8 +372,10 @@ void move_black_king_castle(struct board *bd, int from, int to)
                 delta_hash ^=
                         data_zobrist[zobrist_black_rook][H8] ^
                         data_zobrist[zobrist_black_rook_castle][H8];
-                bd->current->pawn_king_hash ^=
-                        data_zobrist[zobrist_black_rook_castle][H8];
+                if (KEYS_ENABLED(bd)) {
+                        bd->current->pawn_king_hash ^=
+                                data_zobrist[zobrist_black_rook_castle][H8];
+                }
         }
 
         /*
@@ -342,7 +383,9 @@ void move_black_king_castle(struct board *bd, int from, int to)
          */
         move_black_king(bd, from, to);
 
-        bd->current->board_hash_lazy ^= delta_hash; // must apply delta_hash AFTER because move function sets it
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^= delta_hash; // must apply delta_hash AFTER because move function sets it
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -357,14 +400,16 @@ void move_white_king(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_king][from] ^
-                data_zobrist[zobrist_white_king][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_king][from] ^
+                        data_zobrist[zobrist_white_king][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_king][from] ^
-                data_zobrist[zobrist_white_king][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_king][from] ^
+                        data_zobrist[zobrist_white_king][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -380,14 +425,16 @@ void move_black_king(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_king][from] ^
-                data_zobrist[zobrist_black_king][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_king][from] ^
+                        data_zobrist[zobrist_black_king][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_king][from] ^
-                data_zobrist[zobrist_black_king][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_king][from] ^
+                        data_zobrist[zobrist_black_king][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -477,10 +524,12 @@ void move_white_queen(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_queen][from] ^
-                data_zobrist[zobrist_white_queen][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_queen][from] ^
+                        data_zobrist[zobrist_white_queen][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -496,10 +545,12 @@ void move_black_queen(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_queen][from] ^
-                data_zobrist[zobrist_black_queen][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_queen][from] ^
+                        data_zobrist[zobrist_black_queen][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -598,11 +649,13 @@ void move_white_rook_castle(struct board *bd, int from, int to)
          */
         move_white_rook(bd, from, to);
 
-        bd->current->board_hash_lazy ^=
-                data_zobrist[zobrist_white_rook][from] ^
-                data_zobrist[zobrist_white_rook_castle][from];
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_rook_castle][from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^=
+                        data_zobrist[zobrist_white_rook][from] ^
+                        data_zobrist[zobrist_white_rook_castle][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_rook_castle][from];
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -633,11 +686,13 @@ void move_black_rook_castle(struct board *bd, int from, int to)
          */
         move_black_rook(bd, from, to);
 
-        bd->current->board_hash_lazy ^=
-                data_zobrist[zobrist_black_rook][from] ^
-                data_zobrist[zobrist_black_rook_castle][from];
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_rook_castle][from];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy ^=
+                        data_zobrist[zobrist_black_rook][from] ^
+                        data_zobrist[zobrist_black_rook_castle][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_rook_castle][from];
+        }
 }
 
 /*----------------------------------------------------------------------*/
@@ -652,10 +707,12 @@ void move_white_rook(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_rook][from] ^
-                data_zobrist[zobrist_white_rook][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_rook][from] ^
+                        data_zobrist[zobrist_white_rook][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -671,10 +728,12 @@ void move_black_rook(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_rook][from] ^
-                data_zobrist[zobrist_black_rook][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_rook][from] ^
+                        data_zobrist[zobrist_black_rook][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -756,10 +815,12 @@ void move_white_bishop(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_bishop][from] ^
-                data_zobrist[zobrist_white_bishop][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_bishop][from] ^
+                        data_zobrist[zobrist_white_bishop][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -775,10 +836,12 @@ void move_black_bishop(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_bishop][from] ^
-                data_zobrist[zobrist_black_bishop][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_bishop][from] ^
+                        data_zobrist[zobrist_black_bishop][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -868,10 +931,12 @@ void move_white_knight(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_knight][from] ^
-                data_zobrist[zobrist_white_knight][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_knight][from] ^
+                        data_zobrist[zobrist_white_knight][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -887,10 +952,12 @@ void move_black_knight(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_knight][from] ^
-                data_zobrist[zobrist_black_knight][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_knight][from] ^
+                        data_zobrist[zobrist_black_knight][to];
+        }
 
         /*
          *  The rest is generic (tail call)
@@ -1025,14 +1092,16 @@ void move_white_pawn(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_pawn][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_pawn][to];
+        }
 
         /*------------------------------------------------------+
          |      Withdraw piece attacks from original square     |
@@ -1153,14 +1222,16 @@ void move_black_pawn(struct board *bd, int from, int to)
          |      Update Zobrist hashes                           |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_pawn][to];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_pawn][to];
+        }
 
         /*------------------------------------------------------+
          |      Withdraw piece attacks from original square     |
@@ -0,0 +1,419 @@
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      pdb.c -- Persistent database of perft counts                    |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE // for flock
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  System includes
+ */
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Other module includes
+ */
+#include "board.h"
+#include "records.h"
+
+/*
+ *  Own interface include
+ */
+#include "pdb.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define PDB_HEADER "RookiePerftDB 1\n"
+#define PDB_HEADER_SIZE 16
+
+/*
+ *  Entry layout: the canonical position, the count as 8 bytes little
+ *  endian, the depth, 3 zero bytes and the check as 4 bytes little endian
+ */
+#define PDB_ENTRY_COUNT BOARD_BINARY_SIZE
+#define PDB_ENTRY_DEPTH (PDB_ENTRY_COUNT + 8)
+#define PDB_ENTRY_CHECK (PDB_ENTRY_DEPTH + 4)
+#define PDB_ENTRY_SIZE  (PDB_ENTRY_CHECK + 4)
+
+/*
+ *  The index holds entry numbers plus one, 0 for free slots.
+ *  It is kept at most half full.
+ */
+#define PDB_INDEX_MIN_LEN 1024
+
+struct pdb_entry {
+        uint8_t v[PDB_ENTRY_SIZE];
+};
+
+struct pdb {
+        int fd;
+        bool appending;
+        atomic_flag lock;
+
+        const uint8_t *map;     // the entries that existed at open
+        size_t map_size;
+        long long nr_mapped;
+
+        List(struct pdb_entry) added; // entries from this process
+
+        uint32_t *index;
+        long long index_len;
+        long long nr_indexed;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Entries                                                         |
+ +----------------------------------------------------------------------*/
+
+static
+unsigned long long entry_hash(const uint8_t *entry)
+{
+        struct board_binary pos;
+        memcpy(&pos, entry, sizeof pos);
+        return record_hash(&pos) ^ entry[PDB_ENTRY_DEPTH];
+}
+
+static
+uint32_t entry_check(const uint8_t *entry)
+{
+        unsigned long long h = entry_hash(entry);
+        for (int i=PDB_ENTRY_COUNT; i<PDB_ENTRY_DEPTH; i++) {
+                h = (h ^ entry[i]) * 0x9e3779b97f4a7c15ULL;
+        }
+        return (uint32_t) (h >> 32);
+}
+
+static
+void entry_encode(
+        uint8_t entry[PDB_ENTRY_SIZE],
+        const struct board_binary *pos,
+        int depth,
+        long long count)
+{
+        memset(entry, 0, PDB_ENTRY_SIZE);
+        memcpy(entry, pos, BOARD_BINARY_SIZE);
+
+        unsigned long long u = (unsigned long long) count;
+        for (int i=PDB_ENTRY_COUNT; i<PDB_ENTRY_DEPTH; i++) {
+                entry[i] = u & 0xff;
+                u >>= 8;
+        }
+        entry[PDB_ENTRY_DEPTH] = depth;
+
+        uint32_t check = entry_check(entry);
+        for (int i=PDB_ENTRY_CHECK; i<PDB_ENTRY_SIZE; i++) {
+                entry[i] = check & 0xff;
+                check >>= 8;
+        }
+}
+
+static
+bool entry_valid(const uint8_t *entry)
+{
+        uint32_t check = 0;
+        for (int i=PDB_ENTRY_SIZE-1; i>=PDB_ENTRY_CHECK; i--) {
+                check = (check << 8) | entry[i];
+        }
+        return check == entry_check(entry);
+}
+
+static
+long long entry_count(const uint8_t *entry)
+{
+        unsigned long long u = 0;
+        for (int i=PDB_ENTRY_DEPTH-1; i>=PDB_ENTRY_COUNT; i--) {
+                u = (u << 8) | entry[i];
+        }
+        return (long long) u;
+}
+
+static
+const uint8_t *get_entry(struct pdb *db, long long n)
+{
+        if (n < db->nr_mapped) {
+                return &db->map[PDB_HEADER_SIZE + n * PDB_ENTRY_SIZE];
+        } else {
+                return db->added.v[n - db->nr_mapped].v;
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      Index                                                           |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Find the slot of the entry with the same key as `entry',
+ *  or else the free slot where it belongs
+ */
+static
+long long find_slot(struct pdb *db, const uint8_t *entry)
+{
+        long long mask = db->index_len - 1;
+        long long slot = entry_hash(entry) & mask;
+
+        for (; db->index[slot] != 0; slot = (slot + 1) & mask) {
+                const uint8_t *other = get_entry(db, db->index[slot] - 1);
+                if ((memcmp(other, entry, BOARD_BINARY_SIZE) == 0) &&
+                    (other[PDB_ENTRY_DEPTH] == entry[PDB_ENTRY_DEPTH]))
+                        break;
+        }
+        return slot;
+}
+
+static
+err_t grow_index(struct pdb *db)
+{
+        err_t err = OK;
+        uint32_t *old_index = db->index;
+        long long old_len = db->index_len;
+
+        long long len = max(2 * old_len, PDB_INDEX_MIN_LEN);
+        db->index = calloc(len, sizeof(db->index[0]));
+        if (db->index == null) {
+                db->index = old_index;
+                xRaise(ERR_NO_MEMORY);
+        }
+        db->index_len = len;
+
+        for (long long i=0; i<old_len; i++) {
+                if (old_index[i] != 0) {
+                        const uint8_t *entry = get_entry(db, old_index[i] - 1);
+                        db->index[find_slot(db, entry)] = old_index[i];
+                }
+        }
+        free(old_index);
+cleanup:
+        return err;
+}
+
+/*
+ *  Index entry n unless its key is already there
+ */
+static
+err_t index_entry(struct pdb *db, long long n)
+{
+        err_t err = OK;
+
+        if (2 * (db->nr_indexed + 1) > db->index_len) {
+                err = grow_index(db);
+                check(err);
+        }
+
+        const uint8_t *entry = get_entry(db, n);
+        long long slot = find_slot(db, entry);
+        if (db->index[slot] == 0) {
+                db->index[slot] = n + 1;
+                db->nr_indexed++;
+        }
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      pdb_open                                                        |
+ +----------------------------------------------------------------------*/
+
+err_t pdb_open(struct pdb **db_p, const char *path)
+{
+        err_t err = OK;
+        struct pdb *db = null;
+
+        db = calloc(1, sizeof(*db));
+        if (db == null) xRaise(ERR_NO_MEMORY);
+        db->fd = -1;
+        atomic_flag_clear(&db->lock);
+
+        db->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0666);
+        if (db->fd >= 0) {
+                db->appending = (flock(db->fd, LOCK_EX | LOCK_NB) == 0);
+        } else {
+                db->fd = open(path, O_RDONLY);
+        }
+        if (db->fd < 0) xRaise("Cannot open perft database");
+
+        struct stat st;
+        if (fstat(db->fd, &st) != 0) xRaise("Cannot open perft database");
+        off_t size = st.st_size;
+
+        if (size == 0 && db->appending) {
+                if (write(db->fd, PDB_HEADER, PDB_HEADER_SIZE) != PDB_HEADER_SIZE)
+                        xRaise("Write error on perft database");
+                size = PDB_HEADER_SIZE;
+        }
+
+        if (size > 0) {
+                db->map_size = size;
+                void *p = mmap(null, size, PROT_READ, MAP_SHARED, db->fd, 0);
+                if (p == MAP_FAILED) xRaise("Cannot map perft database");
+                db->map = p;
+                if (size < PDB_HEADER_SIZE || memcmp(db->map, PDB_HEADER, PDB_HEADER_SIZE) != 0)
+                        xRaise("Invalid perft database");
+                db->nr_mapped = (size - PDB_HEADER_SIZE) / PDB_ENTRY_SIZE;
+        }
+
+        /*
+         *  A partial entry at the end is from an interrupted append.
+         *  Cut it off before appending behind it.
+         */
+        off_t whole = PDB_HEADER_SIZE + db->nr_mapped * PDB_ENTRY_SIZE;
+        if (db->appending && size > whole) {
+                if (ftruncate(db->fd, whole) != 0)
+                        xRaise("Write error on perft database");
+        }
+
+        for (long long n=0; n<db->nr_mapped; n++) {
+                if (entry_valid(get_entry(db, n))) {
+                        err = index_entry(db, n);
+                        check(err);
+                }
+        }
+
+        *db_p = db;
+        db = null;
+cleanup:
+        pdb_close(db);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      pdb_close                                                       |
+ +----------------------------------------------------------------------*/
+
+void pdb_close(struct pdb *db)
+{
+        if (db != null) {
+                if (db->map != null)
+                        munmap((void *) db->map, db->map_size);
+                if (db->fd >= 0)
+                        close(db->fd); // also releases the lock
+                freeList(db->added);
+                free(db->index);
+                free(db);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      pdb_appending                                                   |
+ +----------------------------------------------------------------------*/
+
+bool pdb_appending(struct pdb *db)
+{
+        return db->appending;
+}
+
+/*----------------------------------------------------------------------+
+ |      pdb_lookup                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Lookups and appends are rare compared to the work they save,
+ *  so one spin lock is enough
+ */
+static
+void lock(struct pdb *db)
+{
+        while (atomic_flag_test_and_set_explicit(&db->lock, memory_order_acquire))
+                ;
+}
+
+static
+void unlock(struct pdb *db)
+{
+        atomic_flag_clear_explicit(&db->lock, memory_order_release);
+}
+
+bool pdb_lookup(struct pdb *db, const struct board_binary *pos, int depth, long long *count_p)
+{
+        assert(depth >= 0 && depth <= PDB_MAX_DEPTH);
+
+        uint8_t key[PDB_ENTRY_SIZE];
+        struct board_binary canonical = *pos;
+        record_canonical(&canonical);
+        entry_encode(key, &canonical, depth, 0);
+
+        bool found = false;
+        lock(db);
+        if (db->index_len > 0) {
+                long long slot = find_slot(db, key);
+                if (db->index[slot] != 0) {
+                        *count_p = entry_count(get_entry(db, db->index[slot] - 1));
+                        found = true;
+                }
+        }
+        unlock(db);
+        return found;
+}
+
+/*----------------------------------------------------------------------+
+ |      pdb_append                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Each entry goes to the file with a single write, so that other
+ *  processes never see more than one partial entry at the end
+ */
+err_t pdb_append(struct pdb *db, const struct board_binary *pos, int depth, long long count)
+{
+        err_t err = OK;
+        struct pdb_entry entry;
+
+        assert(depth >= 0 && depth <= PDB_MAX_DEPTH);
+        assert(count >= 0);
+
+        struct board_binary canonical = *pos;
+        record_canonical(&canonical);
+        entry_encode(entry.v, &canonical, depth, count);
+
+        lock(db);
+
+        bool known = (db->index_len > 0) && (db->index[find_slot(db, entry.v)] != 0);
+        if (!known) {
+                if (db->appending) {
+                        if (write(db->fd, entry.v, PDB_ENTRY_SIZE) != PDB_ENTRY_SIZE)
+                                xRaise("Write error on perft database");
+                }
+                pushList(db->added, entry);
+                err = index_entry(db, db->nr_mapped + db->added.len - 1);
+                check(err);
+        }
+cleanup:
+        unlock(db);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,71 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      pdb.h -- Persistent database of perft counts                    |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Exact node counts by position and depth, kept in a file between
+ *      runs. The file is a header followed by fixed-width entries, only
+ *      ever appended to. Opening maps the existing entries and indexes
+ *      them in memory. Entries added later go to the end of the file
+ *      and to the same index.
+ *
+ *      The key is the full binary record of the canonical position (see
+ *      record_canonical), compared byte for byte, so a hit is never a
+ *      collision. Each entry also has a check word, and entries that
+ *      fail it, such as a torn write after a crash, are ignored.
+ *
+ *      Any number of processes can read the file while one appends to
+ *      it. The appender holds an exclusive lock on the file. A process
+ *      that can't get the lock, or can't write the file, uses it read
+ *      only. Readers see the entries that existed when they opened it.
+ *
+ *      Within a process the database can be used from any thread.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include "cplus.h"
+ *  #include "board.h"
+ *  #include "pdb.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define PDB_MAX_DEPTH 255
+
+struct pdb;
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Open or create a database file
+ */
+err_t pdb_open(struct pdb **db_p, const char *path);
+void pdb_close(struct pdb *db);
+
+/*
+ *  True if new entries go to the file, not only to memory
+ */
+bool pdb_appending(struct pdb *db);
+
+/*
+ *  Lookup and add node counts. The position doesn't have to be canonical.
+ */
+bool pdb_lookup(struct pdb *db, const struct board_binary *pos, int depth, long long *count_p);
+err_t pdb_append(struct pdb *db, const struct board_binary *pos, int depth, long long count);
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
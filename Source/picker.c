@@ -0,0 +1,252 @@
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      picker.c -- Staged move picker for search                       |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Give the legal moves of a position one at a time, in the order
+ *      that search wants to try them, and generate each group of moves
+ *      only when the previous one is exhausted:
+ *
+ *      1. The hash move
+ *      2. Good captures and promotions, best static exchange first
+ *      3. Killer moves of the current frame
+ *      4. The other regular moves, by board_move_sort_value
+ *      5. Bad captures, by board_move_sort_value
+ *
+ *      In check there is just one group after the hash move: the
+ *      escapes, by board_move_sort_value.
+ *
+ *      The generators make only legal moves, so a hash move or a killer
+ *      can only be given after it has been found in a generated list.
+ *      A hash move that isn't a capture or promotion therefore brings
+ *      forward the generation of the regular moves. Still, a cutoff on
+ *      the hash move or on a good capture saves the regular moves in
+ *      all other cases.
+ *
+ *      Sorting is incremental: each move is selected as the best of
+ *      the remaining ones when it is asked for.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Copyright                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  This file is part of the Rookie(TM) Chess Program
+ *  Copyright (C) 1992-2012, Marcel van Kervinck
+ *  All rights reserved.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "board.h"
+
+/*
+ *  Other includes
+ */
+#include "exchange.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+enum pick_stage {
+        pick_hash_move,
+        pick_good_captures,
+        pick_killer_moves,
+        pick_regular_moves,
+        pick_bad_captures,
+        pick_escapes,
+        pick_done,
+};
+
+/*
+ *  Non-losing captures have all 4 highest prescore bits set
+ */
+#define PICK_GOOD_PRESCORE (EXCHANGE_NEUTRAL + EXCHANGE_GOOD_MOVE_OFFSET)
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Move the given move to the front of moves[*next_p .. end), and
+ *  take it from there. False if it isn't in that range.
+ */
+static
+bool take_move(union board_move moves[], int *next_p, int end, int move)
+{
+        for (int i=*next_p; i<end; i++) {
+                if (moves[i].bm.move == move) {
+                        union board_move swap = moves[i];
+                        moves[i] = moves[*next_p];
+                        moves[*next_p] = swap;
+                        (*next_p)++;
+                        return true;
+                }
+        }
+        return false;
+}
+
+/*
+ *  Move the best of moves[next .. end) to the front, without taking it
+ */
+static
+void select_best(union board_move moves[], int next, int end)
+{
+        assert(next < end);
+
+        int best = next;
+        for (int i=next+1; i<end; i++) {
+                if (board_move_sort_value(moves[i]) > board_move_sort_value(moves[best])) {
+                        best = i;
+                }
+        }
+        union board_move swap = moves[best];
+        moves[best] = moves[next];
+        moves[next] = swap;
+}
+
+/*
+ *  The regular moves go behind the captures
+ */
+static
+void generate_regular_moves(struct board_move_picker *picker)
+{
+        assert(!picker->have_regular_moves);
+        assert(picker->nr_moves == picker->nr_captures);
+
+        picker->nr_moves += board_generate_regular_moves(
+                picker->bd, &picker->moves[picker->nr_moves]);
+        picker->have_regular_moves = true;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_picker_init                                               |
+ +----------------------------------------------------------------------*/
+
+void board_picker_init(
+        struct board_move_picker *picker,
+        struct board *bd,
+        int hash_move)
+{
+        picker->bd = bd;
+        picker->stage = pick_hash_move;
+        picker->hash_move = hash_move;
+        picker->killer = 0;
+        picker->next_capture = 0;
+        picker->nr_captures = 0;
+        picker->next_regular = 0;
+        picker->nr_moves = 0;
+        picker->have_regular_moves = false;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_picker_next                                               |
+ +----------------------------------------------------------------------*/
+
+union board_move *board_picker_next(struct board_move_picker *picker)
+{
+        struct board *bd = picker->bd;
+        union board_move *moves = picker->moves;
+
+        switch (picker->stage) {
+
+        case pick_hash_move:
+                if (board_in_check(bd)) {
+                        picker->nr_captures = board_generate_escapes(bd, moves);
+                        picker->nr_moves = picker->nr_captures;
+                        picker->stage = pick_escapes;
+                        if (picker->hash_move != 0 &&
+                            take_move(moves, &picker->next_capture, picker->nr_captures, picker->hash_move)
+                        ) {
+                                return &moves[picker->next_capture - 1];
+                        }
+                        return board_picker_next(picker);
+                }
+
+                picker->nr_captures = board_generate_captures_and_promotions(bd, moves);
+                picker->nr_moves = picker->nr_captures;
+                picker->next_regular = picker->nr_captures;
+                picker->stage = pick_good_captures;
+
+                if (picker->hash_move != 0) {
+                        if (take_move(moves, &picker->next_capture, picker->nr_captures, picker->hash_move)) {
+                                return &moves[picker->next_capture - 1];
+                        }
+                        generate_regular_moves(picker);
+                        if (take_move(moves, &picker->next_regular, picker->nr_moves, picker->hash_move)) {
+                                return &moves[picker->next_regular - 1];
+                        }
+                }
+                /* FALL THROUGH */
+
+        case pick_good_captures:
+                if (picker->next_capture < picker->nr_captures) {
+                        select_best(moves, picker->next_capture, picker->nr_captures);
+                        if (moves[picker->next_capture].bm.prescore >= PICK_GOOD_PRESCORE) {
+                                return &moves[picker->next_capture++];
+                        }
+                }
+                picker->stage = pick_killer_moves;
+                /* FALL THROUGH */
+
+        case pick_killer_moves:
+                if (!picker->have_regular_moves) {
+                        generate_regular_moves(picker);
+                }
+                while (picker->killer < BOARD_MAX_KILLER_MOVES) {
+                        int killer = bd->current->killer_moves[picker->killer++];
+                        if (killer != 0 &&
+                            take_move(moves, &picker->next_regular, picker->nr_moves, killer)
+                        ) {
+                                return &moves[picker->next_regular - 1];
+                        }
+                }
+                picker->stage = pick_regular_moves;
+                /* FALL THROUGH */
+
+        case pick_regular_moves:
+                if (picker->next_regular < picker->nr_moves) {
+                        select_best(moves, picker->next_regular, picker->nr_moves);
+                        return &moves[picker->next_regular++];
+                }
+                picker->stage = pick_bad_captures;
+                /* FALL THROUGH */
+
+        case pick_bad_captures:
+        case pick_escapes:
+                if (picker->next_capture < picker->nr_captures) {
+                        select_best(moves, picker->next_capture, picker->nr_captures);
+                        return &moves[picker->next_capture++];
+                }
+                picker->stage = pick_done;
+                /* FALL THROUGH */
+
+        case pick_done:
+        default:
+                return null;
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
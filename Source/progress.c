@@ -0,0 +1,292 @@
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      progress.c -- Periodic progress reports of long runs            |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE // for fileno
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ *  System includes
+ */
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "progress.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+struct progress {
+        const char *name;
+        int nr_counters;
+        struct progress_counter *counters;
+
+        double interval;
+        int input_fd;
+        long long input_size;           // 0 if unknown
+        _Atomic long long input_offset; // -1 if the fd tells
+        _Atomic long long input_positions; // taken in, 0 if not told
+
+        /*
+         *  Each report arms the alarm for the next one. The one before
+         *  has returned by then, so the new report can clear it.
+         */
+        atomic_flag lock;
+        bool stopping;
+        xAlarm_t alarm;                 // the next report
+        xAlarm_t previous;              // the running or last report
+
+        /*
+         *  The previous sample, for the rates since then
+         */
+        double start_time;
+        double last_time;
+        long long last_nodes;
+        double *last_busy;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+static
+void lock(struct progress *progress)
+{
+        while (atomic_flag_test_and_set_explicit(&progress->lock, memory_order_acquire))
+                ;
+}
+
+static
+void unlock(struct progress *progress)
+{
+        atomic_flag_clear_explicit(&progress->lock, memory_order_release);
+}
+
+static
+double busy_time(struct progress_counter *counter, double now)
+{
+        double mark = atomic_load_explicit(&counter->busy_mark, memory_order_relaxed);
+        return (mark < 0.0) ? mark + now : mark;
+}
+
+/*
+ *  Sample all counters and print one line. Periodic reports give the
+ *  rates since the previous one, the final report those of the run.
+ */
+static
+void report(struct progress *progress, bool final)
+{
+        double now = xTime();
+        double elapsed = now - progress->start_time;
+        double delta = final ? elapsed : now - progress->last_time;
+
+        long long positions = 0;
+        long long nodes = 0;
+        for (int i=0; i<progress->nr_counters; i++) {
+                positions += atomic_load_explicit(&progress->counters[i].positions, memory_order_relaxed);
+                nodes += atomic_load_explicit(&progress->counters[i].nodes, memory_order_relaxed);
+        }
+
+        long long new_nodes = final ? nodes : nodes - progress->last_nodes;
+        char line[1024];
+        int len = snprintf(line, sizeof line,
+                "%s: %.0fs, %lld positions, %lld nodes, %.3g nodes/s",
+                progress->name, elapsed, positions, nodes,
+                (delta > 0.0) ? new_nodes / delta : 0.0);
+
+        if (!final && progress->input_size > 0) {
+                long long offset = atomic_load_explicit(&progress->input_offset, memory_order_relaxed);
+                if (offset < 0)
+                        offset = lseek(progress->input_fd, 0, SEEK_CUR);
+                double read = (offset > 0) ? (double) offset / progress->input_size : 0.0;
+                read = min(read, 1.0);
+                len += snprintf(&line[len], sizeof line - len, ", %.1f%% read", read * 100.0);
+
+                // the input holds about taken / read positions in all
+                double done = read;
+                long long taken = atomic_load_explicit(&progress->input_positions, memory_order_relaxed);
+                if (taken > 0)
+                        done = min((double) positions * read / taken, 1.0);
+                if (done > 0.0) {
+                        len += snprintf(&line[len], sizeof line - len, ", %.0fs to go",
+                                elapsed * (1.0 - done) / done);
+                }
+        }
+
+        len += snprintf(&line[len], sizeof line - len, ", busy");
+        for (int i=0; i<progress->nr_counters && len < (int) sizeof line; i++) {
+                double busy = busy_time(&progress->counters[i], now);
+                double last = final ? 0.0 : progress->last_busy[i];
+                double share = (delta > 0.0) ? (busy - last) / delta : 0.0;
+                share = max(0.0, min(share, 1.0));
+                len += snprintf(&line[len], sizeof line - len, " %.0f", share * 100.0);
+                progress->last_busy[i] = busy;
+        }
+        fprintf(stderr, "%s%%\n", line);
+        fflush(stderr);
+
+        progress->last_time = now;
+        progress->last_nodes = nodes;
+}
+
+/*
+ *  Alarm main
+ */
+static
+void report_and_rearm(void *data)
+{
+        struct progress *progress = data;
+
+        report(progress, false);
+
+        xAlarm_t done = null;
+        lock(progress);
+        if (!progress->stopping) {
+                done = progress->previous;
+                progress->previous = progress->alarm;
+                progress->alarm = setAlarm(progress->interval, report_and_rearm, progress);
+        }
+        unlock(progress);
+        clearAlarm(done);
+}
+
+/*----------------------------------------------------------------------+
+ |      progress_create                                                 |
+ +----------------------------------------------------------------------*/
+
+err_t progress_create(
+        struct progress **progress_p,
+        const char *name,
+        int nr_counters,
+        double interval,
+        FILE *input)
+{
+        err_t err = OK;
+        struct progress *progress = null;
+
+        assert(nr_counters > 0);
+
+        progress = calloc(1, sizeof(*progress));
+        if (progress == null) xRaise(ERR_NO_MEMORY);
+        atomic_flag_clear(&progress->lock);
+
+        progress->name = name;
+        progress->nr_counters = nr_counters;
+        progress->input_fd = (input != null) ? fileno(input) : -1;
+        atomic_init(&progress->input_offset, -1);
+        atomic_init(&progress->input_positions, 0);
+
+        size_t size = nr_counters * sizeof(progress->counters[0]);
+        progress->counters = aligned_alloc(_Alignof(struct progress_counter), size);
+        progress->last_busy = calloc(nr_counters, sizeof(progress->last_busy[0]));
+        if (progress->counters == null || progress->last_busy == null)
+                xRaise(ERR_NO_MEMORY);
+
+        for (int i=0; i<nr_counters; i++) {
+                atomic_init(&progress->counters[i].positions, 0);
+                atomic_init(&progress->counters[i].nodes, 0);
+                atomic_init(&progress->counters[i].busy_mark, 0.0);
+        }
+
+        struct stat st;
+        if (progress->input_fd >= 0 && fstat(progress->input_fd, &st) == 0 && S_ISREG(st.st_mode))
+                progress->input_size = st.st_size;
+
+        progress->start_time = xTime();
+        progress->last_time = progress->start_time;
+
+        progress->interval = interval; // only now ready for reports
+        if (interval > 0.0)
+                progress->alarm = setAlarm(interval, report_and_rearm, progress);
+
+        *progress_p = progress;
+        progress = null;
+cleanup:
+        progress_destroy(progress);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      progress_destroy                                                |
+ +----------------------------------------------------------------------*/
+
+void progress_destroy(struct progress *progress)
+{
+        if (progress == null)
+                return;
+
+        lock(progress);
+        progress->stopping = true;
+        xAlarm_t alarm = progress->alarm;
+        xAlarm_t previous = progress->previous;
+        unlock(progress);
+
+        clearAlarm(alarm);
+        clearAlarm(previous);
+
+        if (progress->interval > 0.0)
+                report(progress, true);
+
+        free(progress->counters);
+        free(progress->last_busy);
+        free(progress);
+}
+
+/*----------------------------------------------------------------------+
+ |      progress_input_offset                                           |
+ +----------------------------------------------------------------------*/
+
+void progress_input_offset(struct progress *progress, long long offset)
+{
+        atomic_store_explicit(&progress->input_offset, offset, memory_order_relaxed);
+}
+
+/*----------------------------------------------------------------------+
+ |      progress_input_positions                                        |
+ +----------------------------------------------------------------------*/
+
+void progress_input_positions(struct progress *progress, long long nr_positions)
+{
+        long long taken = atomic_load_explicit(&progress->input_positions, memory_order_relaxed);
+        atomic_store_explicit(&progress->input_positions, taken + nr_positions, memory_order_relaxed);
+}
+
+/*----------------------------------------------------------------------+
+ |      progress_counter                                                |
+ +----------------------------------------------------------------------*/
+
+struct progress_counter *progress_counter(struct progress *progress, int i)
+{
+        assert(i >= 0 && i < progress->nr_counters);
+        return &progress->counters[i];
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,118 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      progress.h -- Periodic progress reports of long runs            |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Each thread of the program keeps its own counters of the input
+ *      positions it has consumed, the nodes it has counted and the time
+ *      it has been busy. Only that thread writes them, with relaxed
+ *      atomic loads and stores and no read-modify-write, so the hot loop
+ *      never waits for a lock or a shared cache line. An alarm thread samples all counters at every interval
+ *      and prints a line to stderr with the totals, the node rate since
+ *      the previous report, the time to completion and the share of the
+ *      time each thread was busy.
+ *
+ *      The time to completion is estimated from the positions done so
+ *      far. When the reader tells how many positions it has taken in,
+ *      the positions in the whole input file are those in proportion to
+ *      how much of the file has been read. Without that count, the share
+ *      of the file read stands in for the share done. A pipe has no size,
+ *      so then the time to completion is left out.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include <assert.h>
+ *  #include <stdatomic.h>
+ *  #include <stdio.h>
+ *  #include "cplus.h"
+ *  #include "progress.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+struct progress;
+
+/*
+ *  The busy mark is the busy time so far while idle, and that minus
+ *  the time the thread became busy while busy. The wall clock is
+ *  far beyond any busy time, so the sign tells which, and one atomic
+ *  double is enough for a consistent sample.
+ */
+struct progress_counter {
+        _Alignas(64)
+        _Atomic long long positions;
+        _Atomic long long nodes;
+        _Atomic double busy_mark;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Create counters for nr_counters threads. With an interval (seconds)
+ *  the reports run until progress_destroy, which prints a final one.
+ *  The input file, or null, is for the time to completion.
+ */
+err_t progress_create(
+        struct progress **progress_p,
+        const char *name,
+        int nr_counters,
+        double interval,
+        FILE *input);
+void progress_destroy(struct progress *progress);
+
+struct progress_counter *progress_counter(struct progress *progress, int i);
+
+/*
+ *  For input that is read without moving the file offset, such as a
+ *  mapped file (see inputMapOffset): the reading thread tells how far
+ *  it is. With -1 the file offset counts again.
+ */
+void progress_input_offset(struct progress *progress, long long offset);
+
+/*
+ *  For a reader that takes in positions well before they are done: it
+ *  adds the number it has taken in, for the time to completion
+ */
+void progress_input_positions(struct progress *progress, long long nr_positions);
+
+/*
+ *  For use by the owner thread of the counter only
+ */
+static inline void progress_add(struct progress_counter *counter, long long positions, long long nodes)
+{
+        long long p = atomic_load_explicit(&counter->positions, memory_order_relaxed);
+        long long n = atomic_load_explicit(&counter->nodes, memory_order_relaxed);
+        atomic_store_explicit(&counter->positions, p + positions, memory_order_relaxed);
+        atomic_store_explicit(&counter->nodes, n + nodes, memory_order_relaxed);
+}
+
+static inline void progress_busy(struct progress_counter *counter)
+{
+        double mark = atomic_load_explicit(&counter->busy_mark, memory_order_relaxed);
+        assert(mark >= 0.0);
+        atomic_store_explicit(&counter->busy_mark, mark - xTime(), memory_order_relaxed);
+}
+
+static inline void progress_idle(struct progress_counter *counter)
+{
+        double mark = atomic_load_explicit(&counter->busy_mark, memory_order_relaxed);
+        assert(mark < 0.0);
+        atomic_store_explicit(&counter->busy_mark, mark + xTime(), memory_order_relaxed);
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -96,17 +96,19 @@ void promote_white_queen(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_queen][to];
-
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from];
-
-        bd->current->material_key +=
-                data_material_key[board_white_queen] -
-                data_material_key[board_white_pawn];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_queen][to];
+
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from];
+
+                bd->current->material_key +=
+                        data_material_key[board_white_queen] -
+                        data_material_key[board_white_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -259,17 +261,19 @@ void promote_white_rook(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_rook][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_rook][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[board_white_rook] -
-                data_material_key[board_white_pawn];
+                bd->current->material_key +=
+                        data_material_key[board_white_rook] -
+                        data_material_key[board_white_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -422,19 +426,21 @@ void promote_white_bishop(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_bishop][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_bishop][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[ BOARD_SQUARE_IS_LIGHT(to) ?
-                        board_white_bishop_light :
-                        board_white_bishop_dark ] -
-                data_material_key[board_white_pawn];
+                bd->current->material_key +=
+                        data_material_key[ BOARD_SQUARE_IS_LIGHT(to) ?
+                                board_white_bishop_light :
+                                board_white_bishop_dark ] -
+                        data_material_key[board_white_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -595,17 +601,19 @@ void promote_white_knight(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_white_pawn][from] ^
-                data_zobrist[zobrist_white_knight][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_white_pawn][from] ^
+                        data_zobrist[zobrist_white_knight][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_white_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_white_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[board_white_knight] -
-                data_material_key[board_white_pawn];
+                bd->current->material_key +=
+                        data_material_key[board_white_knight] -
+                        data_material_key[board_white_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -781,17 +789,19 @@ void promote_black_queen(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_queen][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_queen][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[board_black_queen] -
-                data_material_key[board_black_pawn];
+                bd->current->material_key +=
+                        data_material_key[board_black_queen] -
+                        data_material_key[board_black_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -944,17 +954,19 @@ void promote_black_rook(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_rook][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_rook][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[board_black_rook] -
-                data_material_key[board_black_pawn];
+                bd->current->material_key +=
+                        data_material_key[board_black_rook] -
+                        data_material_key[board_black_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -1107,19 +1119,21 @@ void promote_black_bishop(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_bishop][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_bishop][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[ BOARD_SQUARE_IS_LIGHT(to) ?
-                        board_black_bishop_light :
-                        board_black_bishop_dark ] -
-                data_material_key[board_black_pawn];
+                bd->current->material_key +=
+                        data_material_key[ BOARD_SQUARE_IS_LIGHT(to) ?
+                                board_black_bishop_light :
+                                board_black_bishop_dark ] -
+                        data_material_key[board_black_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -1280,17 +1294,19 @@ void promote_black_knight(
          |      Update Zobrist hashes and material key          |
          +------------------------------------------------------*/
 
-        bd->current->board_hash_lazy =
-                ~bd->current[-1].board_hash_lazy ^
-                data_zobrist[zobrist_black_pawn][from] ^
-                data_zobrist[zobrist_black_knight][to];
+        if (KEYS_ENABLED(bd)) {
+                bd->current->board_hash_lazy =
+                        ~bd->current[-1].board_hash_lazy ^
+                        data_zobrist[zobrist_black_pawn][from] ^
+                        data_zobrist[zobrist_black_knight][to];
 
-        bd->current->pawn_king_hash ^=
-                data_zobrist[zobrist_black_pawn][from];
+                bd->current->pawn_king_hash ^=
+                        data_zobrist[zobrist_black_pawn][from];
 
-        bd->current->material_key +=
-                data_material_key[board_black_knight] -
-                data_material_key[board_black_pawn];
+                bd->current->material_key +=
+                        data_material_key[board_black_knight] -
+                        data_material_key[board_black_pawn];
+        }
 
         /*------------------------------------------------------+
          |      Occupy to-square                                |
@@ -0,0 +1,182 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      ptable.c -- Transposition table for perft                       |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "ptable.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define PTABLE_BUCKET_LEN 4
+
+/*
+ *  Each entry holds the node count together with the subtree depth,
+ *  and the full position hash as check. Entries with data == 0 are free.
+ *
+ *  The table is shared by all threads without locking. Stores from
+ *  different threads into the same entry can interleave, leaving the
+ *  two words from different stores. The check is therefore kept as
+ *  key XOR data: a torn entry then fails the key comparison just like
+ *  any other miss. Relaxed atomics compile to plain moves here.
+ */
+struct ptable_entry {
+        _Atomic unsigned long long check;
+        _Atomic unsigned long long data;
+};
+
+#define PTABLE_DATA(depth, count) (((unsigned long long) (count) << 8) | (depth))
+#define PTABLE_DEPTH(data) ((int) ((data) & 0xff))
+#define PTABLE_COUNT(data) ((long long) ((data) >> 8))
+
+struct ptable_bucket {
+        struct ptable_entry entries[PTABLE_BUCKET_LEN];
+};
+
+struct ptable {
+        struct ptable_bucket *buckets;
+        unsigned long long mask;
+        size_t size;
+        int memory_flags;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      ptable_create                                                   |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  The number of buckets is rounded down to a power of two
+ */
+err_t ptable_create(struct ptable **table_p, long long size, int memory_flags)
+{
+        err_t err = OK;
+        struct ptable *table = null;
+
+        long long nr_buckets = 1;
+        while (2 * nr_buckets * (long long) sizeof(struct ptable_bucket) <= size) {
+                nr_buckets *= 2;
+        }
+
+        table = calloc(1, sizeof(*table));
+        if (table == null) xRaise(ERR_NO_MEMORY);
+
+        table->size = nr_buckets * sizeof(struct ptable_bucket);
+        table->mask = nr_buckets - 1;
+        table->memory_flags = memory_flags;
+
+        /*
+         *  The memory comes zero-filled, which marks all entries free
+         */
+        table->buckets = allocMemory(table->size, memory_flags);
+        if (table->buckets == null) xRaise(ERR_NO_MEMORY);
+
+        *table_p = table;
+        table = null;
+cleanup:
+        ptable_destroy(table);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      ptable_destroy                                                  |
+ +----------------------------------------------------------------------*/
+
+void ptable_destroy(struct ptable *table)
+{
+        if (table != null) {
+                freeMemory(table->buckets, table->size, table->memory_flags);
+                free(table);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      ptable_probe                                                    |
+ +----------------------------------------------------------------------*/
+
+bool ptable_probe(struct ptable *table, unsigned long long key, int depth, long long *count_p)
+{
+        struct ptable_bucket *bucket = &table->buckets[key & table->mask];
+
+        for (int i=0; i<PTABLE_BUCKET_LEN; i++) {
+                struct ptable_entry *entry = &bucket->entries[i];
+                unsigned long long data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+                unsigned long long check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+                if (((check ^ data) == key) && (data != 0) && (PTABLE_DEPTH(data) == depth)) {
+                        *count_p = PTABLE_COUNT(data);
+                        return true;
+                }
+        }
+        return false;
+}
+
+/*----------------------------------------------------------------------+
+ |      ptable_store                                                    |
+ +----------------------------------------------------------------------*/
+
+void ptable_store(struct ptable *table, unsigned long long key, int depth, long long count)
+{
+        assert(depth > 0 && depth <= PTABLE_MAX_DEPTH);
+
+        if (count > PTABLE_MAX_COUNT) {
+                return;
+        }
+
+        struct ptable_bucket *bucket = &table->buckets[key & table->mask];
+
+        /*
+         *  Replace the shallowest entry. Concurrent stores can make this
+         *  choice less than optimal, which is harmless.
+         */
+        struct ptable_entry *victim = &bucket->entries[0];
+        int victim_depth = PTABLE_MAX_DEPTH + 1;
+        for (int i=0; i<PTABLE_BUCKET_LEN; i++) {
+                struct ptable_entry *entry = &bucket->entries[i];
+                unsigned long long data = atomic_load_explicit(&entry->data, memory_order_relaxed);
+                unsigned long long check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+                if (((check ^ data) == key) && (PTABLE_DEPTH(data) == depth)) {
+                        victim = entry;
+                        break;
+                }
+                if (PTABLE_DEPTH(data) < victim_depth) {
+                        victim = entry;
+                        victim_depth = PTABLE_DEPTH(data);
+                }
+        }
+
+        unsigned long long data = PTABLE_DATA(depth, count);
+        atomic_store_explicit(&victim->data, data, memory_order_relaxed);
+        atomic_store_explicit(&victim->check, key ^ data, memory_order_relaxed);
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,62 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      ptable.h -- Transposition table for perft                       |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Memoize node counts of perft subtrees by position hash and depth.
+ *
+ *      The table is organized in buckets of 4 entries that fill exactly
+ *      one cache line. Within a bucket the shallowest entry gets replaced,
+ *      because it is the cheapest one to calculate again.
+ *
+ *      One table can be shared by any number of threads. Entries are
+ *      verified instead of locked, so a probe or store costs no more
+ *      than the cache miss on its bucket.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include "cplus.h"
+ *  #include "ptable.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Counts are stored in 56 bits, the remaining 8 bits hold the depth
+ */
+#define PTABLE_MAX_DEPTH 255
+#define PTABLE_MAX_COUNT ((1LL << 56) - 1)
+
+struct ptable;
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Create a table using at most `size' bytes. The flags are for
+ *  allocMemory: huge pages, and interleaving over NUMA nodes.
+ */
+err_t ptable_create(struct ptable **table_p, long long size, int memory_flags);
+void ptable_destroy(struct ptable *table);
+
+/*
+ *  Lookup and store node counts
+ */
+bool ptable_probe(struct ptable *table, unsigned long long key, int depth, long long *count_p);
+void ptable_store(struct ptable *table, unsigned long long key, int depth, long long count);
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,293 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      records.c -- Position records for the perft tools               |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "board.h"
+#include "records.h"
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      record_parse_format                                             |
+ +----------------------------------------------------------------------*/
+
+err_t record_parse_format(const char *name, int *format_p)
+{
+        err_t err = OK;
+
+        if (strcmp(name, "csv") == 0)
+                *format_p = record_csv;
+        else if (strcmp(name, "bin") == 0)
+                *format_p = record_binary;
+        else
+                xRaise("Invalid record format");
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      record_read                                                     |
+ +----------------------------------------------------------------------*/
+
+static
+void record_decode(const uint8_t *buffer, struct record *record)
+{
+        memcpy(&record->pos, buffer, BOARD_BINARY_SIZE);
+
+        unsigned long long count = 0;
+        for (int i=RECORD_SIZE-1; i>=BOARD_BINARY_SIZE; i--) {
+                count = (count << 8) | buffer[i];
+        }
+        record->count = (long long) count;
+}
+
+bool record_read(FILE *fp, struct record *record)
+{
+        uint8_t buffer[RECORD_SIZE];
+
+        size_t n = fread(buffer, 1, sizeof buffer, fp);
+        if (n != sizeof buffer) {
+                if (ferror(fp)) xAbort(errno, "fread");
+                if (n != 0) xAbort(EINVAL, "record_read");
+                return false;
+        }
+
+        record_decode(buffer, record);
+        return true;
+}
+
+/*
+ *  The same from an input stream
+ */
+bool record_read_input(xInput_t input, struct record *record)
+{
+        const char *block;
+
+        int n = readBlock(input, &block, RECORD_SIZE);
+        if (n != RECORD_SIZE) {
+                if (n != 0) xAbort(EINVAL, "record_read_input");
+                return false;
+        }
+
+        record_decode((const uint8_t *) block, record);
+        return true;
+}
+
+/*----------------------------------------------------------------------+
+ |      record_write                                                    |
+ +----------------------------------------------------------------------*/
+
+void record_write(FILE *fp, const struct record *record)
+{
+        uint8_t buffer[RECORD_SIZE];
+
+        memcpy(buffer, &record->pos, BOARD_BINARY_SIZE);
+
+        unsigned long long count = (unsigned long long) record->count;
+        for (int i=BOARD_BINARY_SIZE; i<RECORD_SIZE; i++) {
+                buffer[i] = count & 0xff;
+                count >>= 8;
+        }
+
+        if (fwrite(buffer, 1, sizeof buffer, fp) != sizeof buffer)
+                xAbort(errno, "fwrite");
+}
+
+/*----------------------------------------------------------------------+
+ |      record_compare                                                  |
+ +----------------------------------------------------------------------*/
+
+int record_compare(const void *ap, const void *bp)
+{
+        const struct record *a = ap, *b = bp;
+        return memcmp(&a->pos, &b->pos, BOARD_BINARY_SIZE);
+}
+
+/*----------------------------------------------------------------------+
+ |      record_split_csv                                                |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Split a `pos,count' line as given by readSlice. Returns the length
+ *  of the position part. Lines without a count get count 0.
+ */
+int record_split_csv(const char *line, int len, long long *count_p)
+{
+        const char *end = line + len;
+        const char *comma = memchr(line, ',', len);
+
+        if (comma != null) {
+                *count_p = parseLongLong(comma + 1, end);
+                return comma - line;
+        }
+
+        *count_p = 0;
+        return (len > 0 && line[len-1] == '\n') ? len - 1 : len;
+}
+
+/*----------------------------------------------------------------------+
+ |      record_canonical                                                |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Unpack the piece codes into one per square, -1 for empty
+ */
+static
+void unpack_squares(const struct board_binary *pos, signed char squares[BOARD_SIZE])
+{
+        int n = 0;
+        for (int sq=0; sq<BOARD_SIZE; sq++) {
+                if ((pos->occupied[sq >> 3] >> (sq & 7)) & 1) {
+                        squares[sq] = (pos->pieces[n >> 1] >> ((n & 1) * 4)) & 0x0f;
+                        n++;
+                } else
+                        squares[sq] = -1;
+        }
+}
+
+static
+void pack_squares(const signed char squares[BOARD_SIZE], int side_to_move, struct board_binary *pos)
+{
+        memset(pos, 0, sizeof(*pos));
+
+        int n = 0;
+        for (int sq=0; sq<BOARD_SIZE; sq++) {
+                if (squares[sq] >= 0) {
+                        pos->occupied[sq >> 3] |= 1 << (sq & 7);
+                        pos->pieces[n >> 1] |= squares[sq] << ((n & 1) * 4);
+                        n++;
+                }
+        }
+        pos->side_to_move = side_to_move;
+}
+
+/*
+ *  Replace the position by the smallest of its images under the
+ *  symmetries asked for. All have the same perft counts.
+ */
+static
+void smallest_image(
+        struct board_binary *pos,
+        const signed char squares[BOARD_SIZE],
+        bool can_flip,
+        bool can_mirror)
+{
+        signed char image[BOARD_SIZE];
+        struct board_binary best = *pos;
+
+        for (int t=1; t<4; t++) {
+                bool flip = (t & 1) != 0;
+                bool mirror = (t & 2) != 0;
+                if ((flip && !can_flip) || (mirror && !can_mirror))
+                        continue;
+
+                for (int sq=0; sq<BOARD_SIZE; sq++) {
+                        int file = BOARD_FILE(sq);
+                        int rank = BOARD_RANK(sq);
+                        int code = squares[sq];
+                        if (flip && code >= 0)
+                                code ^= board_binary_black;
+                        image[BOARD_SQUARE(mirror ? 7-file : file, flip ? 7-rank : rank)] = code;
+                }
+
+                struct board_binary candidate;
+                pack_squares(image, pos->side_to_move ^ flip, &candidate);
+                if (memcmp(&candidate, &best, sizeof best) < 0)
+                        best = candidate;
+        }
+
+        *pos = best;
+}
+
+static
+bool has_castling_rights(const signed char squares[BOARD_SIZE])
+{
+        for (int sq=0; sq<BOARD_SIZE; sq++) {
+                if ((squares[sq] & ~board_binary_black) == board_binary_rook_castle)
+                        return true;
+        }
+        return false;
+}
+
+/*
+ *  Replace the position by the smallest of its images under swapping
+ *  the colors, and under mirroring the files when nobody can castle.
+ *  Swapping the colors swaps the side to move as well, so within one
+ *  ply only the mirroring merges positions. Mixed sets of positions
+ *  can merge both ways.
+ */
+void record_canonical(struct board_binary *pos)
+{
+        signed char squares[BOARD_SIZE];
+
+        unpack_squares(pos, squares);
+        smallest_image(pos, squares, true, !has_castling_rights(squares));
+}
+
+/*----------------------------------------------------------------------+
+ |      record_reduce                                                   |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Only positions without castling rights have a mirror image, so the
+ *  others stay as they are
+ */
+void record_reduce(struct board_binary *pos)
+{
+        signed char squares[BOARD_SIZE];
+
+        unpack_squares(pos, squares);
+        if (has_castling_rights(squares))
+                return;
+
+        smallest_image(pos, squares, true, true);
+}
+
+/*----------------------------------------------------------------------+
+ |      record_hash                                                     |
+ +----------------------------------------------------------------------*/
+
+unsigned long long record_hash(const struct board_binary *pos)
+{
+        uint64_t words[BOARD_BINARY_SIZE / 8];
+        memcpy(words, pos, sizeof words);
+
+        uint64_t h = 0;
+        for (int i=0; i<arrayLen(words); i++) {
+                h = (h ^ words[i]) * 0x9e3779b97f4a7c15ULL;
+                h ^= h >> 29;
+        }
+        return h;
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,90 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      records.h -- Position records for the perft tools               |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      The tools pass positions with a multiplicity between pipeline
+ *      stages, either as text lines `fen,count' or as fixed-width binary
+ *      records. A binary record is a struct board_binary followed by the
+ *      count as 8 bytes little-endian, 40 bytes in total.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include <stdio.h>
+ *  #include "cplus.h"
+ *  #include "board.h"
+ *  #include "records.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define RECORD_SIZE (BOARD_BINARY_SIZE + 8)
+
+struct record {
+        struct board_binary pos;
+        long long count;
+};
+
+enum record_format {
+        record_csv,
+        record_binary,
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+err_t record_parse_format(const char *name, int *format_p);
+
+/*
+ *  Binary record I/O. record_read returns false at end of input.
+ */
+bool record_read(FILE *fp, struct record *record);
+void record_write(FILE *fp, const struct record *record);
+
+bool record_read_input(xInput_t input, struct record *record);
+
+/*
+ *  Order of records by position, for qsort
+ */
+int record_compare(const void *ap, const void *bp);
+
+/*
+ *  Split a `pos,count' line, giving the length of the position part
+ */
+int record_split_csv(const char *line, int len, long long *count_p);
+
+/*
+ *  Map a position to one representative of its color swapped and,
+ *  without castling rights, mirrored images. These all have the same
+ *  perft counts.
+ */
+void record_canonical(struct board_binary *pos);
+
+/*
+ *  The same, limited to where it can help: positions with castling
+ *  rights are left as they are. The mirror image can merge positions
+ *  within one ply file. The color swapped images can only merge sets
+ *  with both sides to move.
+ */
+void record_reduce(struct board_binary *pos);
+
+/*
+ *  Hash of the record bytes, for positions without a board
+ */
+unsigned long long record_hash(const struct board_binary *pos);
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
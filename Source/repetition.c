@@ -0,0 +1,185 @@
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      repetition.c -- Repetition detection                            |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      Detect repeated positions, and positions where the side to move
+ *      can repeat an earlier one with its next move.
+ *
+ *      Only the positions since the last irreversible move can repeat,
+ *      which the halfmove clock counts. Both scans look at no more than
+ *      that. They compare board_hash_lazy, so they need the keys (see
+ *      board_set_lazy_keys). En passant status is not part of that hash.
+ *
+ *      For the upcoming repetition, the hash difference with each
+ *      earlier position of the opponent to move is looked up in the
+ *      cuckoo table of reversible moves from makeData.c. A hit means
+ *      that moving one of our pieces between two given squares would
+ *      give that position again. Hits are rare, and only then the
+ *      squares and legality of the move are verified. This replaces
+ *      generating and making every move, and comparing the positions.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Copyright                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  This file is part of the Rookie(TM) Chess Program
+ *  Copyright (C) 1992-2013, Marcel van Kervinck
+ *  All rights reserved.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "board.h"
+#include "intern.h"
+
+/*
+ *  Other includes
+ */
+#include "move.h"
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  True if all squares between a and b are empty
+ */
+static
+bool the_path_is_clear(struct board *bd, int a, int b)
+{
+        int step = board_vector_step_compact[DEBRUIJN_INDEX(data_sq2sq[a][b] & BOARD_ATTACK_QUEEN)];
+        assert(step != 0);
+
+        for (int sq=a+step; sq!=b; sq+=step) {
+                assert(BOARD_SQUARE_IS_VALID(sq));
+                if (bd->squares[sq].piece != board_empty) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+/*
+ *  Can the side to move play a piece between squares a and b now?
+ *
+ *  The cuckoo table gives the squares of a reversible move, not its
+ *  direction. One square must hold a piece of ours, the other must be
+ *  empty, and for sliders the squares in between must be empty as
+ *  well. Only then the generator decides on checks and pins.
+ */
+static
+bool reversible_move_is_legal(struct board *bd, int a, int b)
+{
+        int from = a, to = b;
+        if (bd->squares[from].piece == board_empty) {
+                from = b;
+                to = a;
+        }
+
+        int piece = bd->squares[from].piece;
+        if ((bd->squares[to].piece != board_empty) ||
+            (BOARD_PIECE_COLOR(piece) != bd->current->active.color)
+        ) {
+                return false;
+        }
+
+        if ((data_sq2sq[from][to] & BOARD_ATTACK_QUEEN) != 0 &&
+            !the_path_is_clear(bd, from, to)
+        ) {
+                return false;
+        }
+
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_in_check(bd) ?
+                board_generate_escapes_unscored(bd, moves) :
+                board_generate_regular_moves_unscored(bd, moves);
+
+        for (int i=0; i<nr_moves; i++) {
+                if (moves[i].bm.move == MOVE(from, to)) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_check_repetition_fn                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Is the current position a repetition of one since the last
+ *  irreversible move, with the same side to move?
+ */
+bool board_check_repetition_fn(struct board *bd)
+{
+        struct board_stack_frame *frame = bd->current;
+        unsigned long long hash = frame->board_hash_lazy;
+
+        for (int i=4; i<=frame->halfmove_clock; i+=2) {
+                if (frame[-i].board_hash_lazy == hash) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+/*----------------------------------------------------------------------+
+ |      board_check_upcoming_repetition_fn                              |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Does the side to move have a move that repeats a position since the
+ *  last irreversible move? That position is an odd number of ply back,
+ *  because the move itself flips the side to move. One ply back can't
+ *  be repeated by moving our own pieces.
+ */
+bool board_check_upcoming_repetition_fn(struct board *bd)
+{
+        struct board_stack_frame *frame = bd->current;
+        unsigned long long hash = frame->board_hash_lazy;
+        int color = frame->active.color;
+
+        for (int i=3; i<=frame->halfmove_clock; i+=2) {
+                unsigned long long diff = hash ^ frame[-i].board_hash_lazy;
+
+                int slot = DATA_CUCKOO_MOVE_HASH1(diff);
+                if (data_cuckoo_move_keys[color][slot] != DATA_CUCKOO_MOVE_KEY(diff)) {
+                        slot = DATA_CUCKOO_MOVE_HASH2(diff);
+                        if (data_cuckoo_move_keys[color][slot] != DATA_CUCKOO_MOVE_KEY(diff)) {
+                                continue;
+                        }
+                }
+
+                int a = data_cuckoo_squares[color][slot][0];
+                int b = data_cuckoo_squares[color][slot][1];
+                if (reversible_move_is_legal(bd, a, b)) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
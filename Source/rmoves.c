@@ -1,5 +1,5 @@
-
 #include <assert.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -9,6 +9,86 @@
 #include "cplus.h"
 
 #include "board.h"
+#include "compress.h"
+#include "pdb.h"
+#include "progress.h"
+#include "ptable.h"
+#include "records.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Input is processed in batches of lines. The workers count one batch
+ *  while the main thread reads the next one. The workers stay for the
+ *  whole run and wait at a barrier between batches.
+ */
+#define BATCH_MAX_LINES 4096
+
+/*
+ *  Split the positions into root moves when there are too few of them
+ *  to keep all threads busy until the end of a batch
+ */
+#define SPLIT_MIN_JOBS_PER_THREAD 8
+
+/*
+ *  Without a table, positions of this depth or less are quick to count,
+ *  and they are taken from the queue in chunks of up to WORKER_CHUNK.
+ *  The chunks are smaller when that leaves too few for all threads.
+ */
+#define WORKER_CHUNK 64
+#define WORKER_CHUNK_MAX_DEPTH 2
+
+/*
+ *  Shallower positions are as quick to count as to look up
+ */
+#define PDB_MIN_DEPTH 3
+
+/*
+ *  One unit of work: a whole position, or a single root move of it
+ */
+struct perft_job {
+        int line;
+        int move_index; // -1 for all moves
+};
+
+/*
+ *  A line to be added to the database when its last job is done
+ */
+struct perft_root {
+        _Atomic long long count;
+        atomic_int nr_jobs;
+};
+
+struct perft_batch {
+        charList text;                   // input lines, each terminated by '\0'
+        intList offsets;                 // start of each line in text
+        List(struct board_binary) positions; // or binary input
+        List(long long) factors;
+        List(struct perft_job) jobs;     // one per line unless split
+        List(struct board_binary) keys;  // with a database: one per line
+        List(struct perft_root) roots;
+        List(struct board_snapshot) snapshots; // when split: one per line
+        long long known;                 // total of the lines found in it
+        bool split;
+        int chunk;                       // lines per take, or 0 for jobs
+        atomic_int next_job;             // shared queue head
+};
+
+struct perft_worker {
+        struct board *bd;
+        struct ptable *table;
+        struct perft_batch *batch;       // or null to stop
+        int depth;
+        int line;                        // line currently set up in bd
+        long long nr_hits;
+        long long total;
+        struct board_stats stats;        // collected when the thread stops
+        struct progress_counter *counter;
+        err_t err;
+        xThread_t thread;
+};
 
 /*----------------------------------------------------------------------+
  |      Functions                                                       |
@@ -21,6 +101,42 @@ void perft(
         union board_move *moves,
         int nr_moves);
 
+static
+long long perft_hashed(struct perft_worker *worker, int depth);
+
+/*----------------------------------------------------------------------+
+ |      Data                                                            |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Recalculate every Nth hash table hit without the table (0 for never)
+ */
+static long long verify_interval;
+
+static int input_format = record_csv;
+
+/*
+ *  Report the count of each root move as soon as it is known
+ */
+static bool divide;
+
+/*
+ *  Counts of whole input positions from earlier runs
+ */
+static struct pdb *database;
+
+/*
+ *  Counters of the workers, and one more for the reading thread
+ */
+static struct progress *progress;
+
+/*
+ *  The main thread and all workers meet here at the start and at the
+ *  end of each batch
+ */
+static xBarrier_t batch_start;
+static xBarrier_t batch_done;
+
 /*----------------------------------------------------------------------+
  |      board_perft                                                     |
  +----------------------------------------------------------------------*/
@@ -39,19 +155,56 @@ err_t board_perft(struct board *bd, int depth, long long *count_p)
         }
 
         union board_move moves[BOARD_MAX_MOVES];
-        int nr_moves = board_generate_all_moves(bd, moves);
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
 
         if (depth == 1) {
                 count = nr_moves;
         } else {
+                /*
+                 *  The leaf counts accumulate in the frame below the
+                 *  deepest level. Take the difference, so that this
+                 *  also works from an inner node.
+                 */
+                long long before = bd->current[depth].node_counter;
                 perft(bd, depth-2, moves, nr_moves);
-                count = bd->current[depth].node_counter;
+                count = bd->current[depth].node_counter - before;
         }
 done:
         *count_p = count;
         return err;
 }
 
+/*----------------------------------------------------------------------+
+ |      board_perft_batch                                               |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Perft of a list of positions
+ */
+err_t board_perft_batch(
+        struct board *bd,
+        const struct board_binary positions[],
+        int nr_positions,
+        int depth,
+        long long counts[])
+{
+        err_t err = OK;
+        int max_depth = bd->max_depth;
+
+        board_set_max_depth(bd, max(depth, 1));
+
+        for (int i=0; i<nr_positions; i++) {
+                err = board_setup_binary(bd, &positions[i]);
+                check(err);
+                err = board_perft(bd, depth, &counts[i]);
+                check(err);
+        }
+
+cleanup:
+        board_set_max_depth(bd, max_depth);
+        return err;
+}
+
 /*----------------------------------------------------------------------+
  |      perft                                                           |
  +----------------------------------------------------------------------*/
@@ -61,8 +214,8 @@ done:
  *
  *  Because the move generator creates only legal moves, there is no
  *  need to make any moves in the deepest level. We can just count the
- *  moves in the move list as legal nodes. This speeds up perft and
- *  also makes it more useful for testing correctness.
+ *  legal moves, without even putting them in a list. This speeds up
+ *  perft and also makes it more useful for testing correctness.
  */
 static
 void perft(
@@ -71,19 +224,518 @@ void perft(
         union board_move *moves,
         int nr_moves)
 {
+        if (depth_minus_1 == 0) {
+                for (int i=0; i<nr_moves; i++) {
+                        board_make_move(bd, &moves[i]);
+                        bd->current[+1].node_counter += board_count_legal_moves(bd);
+                        board_undo_move(bd);
+                }
+                return;
+        }
+
         for (int i=0; i<nr_moves; i++) {
                 board_make_move(bd, &moves[i]);
                 union board_move new_moves[BOARD_MAX_MOVES];
-                int nr_new_moves = board_generate_all_moves(bd, new_moves);
+                int nr_new_moves = board_generate_all_moves_unscored(bd, new_moves);
+                perft(bd, depth_minus_1 - 1, new_moves, nr_new_moves);
+                board_undo_move(bd);
+        }
+}
 
-                if (depth_minus_1 == 0) {
-                        bd->current[+1].node_counter += nr_new_moves;
-                } else {
-                        perft(bd, depth_minus_1 - 1, new_moves, nr_new_moves);
+/*----------------------------------------------------------------------+
+ |      perft_hashed                                                    |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Perft with memoization of subtree counts
+ *
+ *  Many move orders lead to the same position, and their subtrees
+ *  need to be counted only once. The key is the full position hash,
+ *  so positions that differ only in en-passant status don't mix.
+ *  Depth 1 is not worth a probe: it is just one generator call.
+ *
+ *  A key collision gives a silently wrong count. Hence the option to
+ *  recalculate a sample of the table hits and to abort on any mismatch.
+ */
+static
+long long perft_hashed(struct perft_worker *worker, int depth)
+{
+        struct board *bd = worker->bd;
+        union board_move moves[BOARD_MAX_MOVES];
+        long long count;
+
+        if (depth <= 1) {
+                return (depth == 0) ? 1 : board_count_legal_moves(bd);
+        }
+
+        unsigned long long key = board_hash(bd);
+
+        if (ptable_probe(worker->table, key, depth, &count)) {
+                worker->nr_hits++;
+                if ((verify_interval > 0) && (worker->nr_hits % verify_interval == 0)) {
+                        long long verify_count;
+                        board_perft(bd, depth, &verify_count);
+                        if (verify_count != count) {
+                                char fen[BOARD_MAX_FEN_STRING_SIZE];
+                                board_fen_string(bd, fen);
+                                fprintf(stderr,
+                                        "Hash table mismatch: %s depth %d count %lld expected %lld\n",
+                                        fen, depth, count, verify_count);
+                                abort();
+                        }
                 }
+                return count;
+        }
+
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        count = 0;
+        for (int i=0; i<nr_moves; i++) {
+                board_make_move(bd, &moves[i]);
+                count += perft_hashed(worker, depth-1);
+                board_undo_move(bd);
+        }
+
+        ptable_store(worker->table, key, depth, count);
+
+        return count;
+}
+
+/*----------------------------------------------------------------------+
+ |      perft_count                                                     |
+ +----------------------------------------------------------------------*/
+
+static
+long long perft_count(struct perft_worker *worker, int depth)
+{
+        long long count;
+
+        if (worker->table != null) {
+                count = perft_hashed(worker, depth);
+        } else {
+                board_perft(worker->bd, depth, &count);
+        }
+        return count;
+}
+
+/*----------------------------------------------------------------------+
+ |      perft_root                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Count a whole position, and add the nodes of each root move to the
+ *  progress counter as soon as it is done. A long job then shows up in
+ *  the reports while it runs, not only when it ends.
+ */
+static
+long long perft_root(struct perft_worker *worker, int depth)
+{
+        struct board *bd = worker->bd;
+        union board_move moves[BOARD_MAX_MOVES];
+        long long count;
+
+        if (depth <= 2) {
+                count = perft_count(worker, depth);
+                progress_add(worker->counter, 0, count);
+                return count;
+        }
 
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        count = 0;
+        for (int i=0; i<nr_moves; i++) {
+                board_make_move(bd, &moves[i]);
+                long long move_count = perft_count(worker, depth-1);
                 board_undo_move(bd);
+                progress_add(worker->counter, 0, move_count);
+                count += move_count;
+        }
+        return count;
+}
+
+/*----------------------------------------------------------------------+
+ |      setup_line                                                      |
+ +----------------------------------------------------------------------*/
+
+static
+err_t setup_line(struct board *bd, struct perft_batch *batch, int line)
+{
+        if (line < batch->snapshots.len) {
+                return board_restore(bd, &batch->snapshots.v[line]);
+        } else if (input_format == record_binary) {
+                return board_setup_binary(bd, &batch->positions.v[line]);
+        } else {
+                return board_setup_raw(bd, &batch->text.v[batch->offsets.v[line]]);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      count_chunk                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Count lines [first, first+n) of an unsplit batch without a table.
+ *  Binary records go to board_perft_batch in one call.
+ */
+static
+err_t count_chunk(struct perft_worker *worker, int first, int n)
+{
+        err_t err = OK;
+        struct perft_batch *batch = worker->batch;
+        long long counts[WORKER_CHUNK];
+
+        assert(n <= WORKER_CHUNK);
+
+        if (input_format == record_binary) {
+                err = board_perft_batch(worker->bd, &batch->positions.v[first], n, worker->depth, counts);
+                check(err);
+        } else {
+                for (int i=0; i<n; i++) {
+                        err = setup_line(worker->bd, batch, first + i);
+                        check(err);
+                        err = board_perft(worker->bd, worker->depth, &counts[i]);
+                        check(err);
+                }
         }
+
+        long long nodes = 0;
+        for (int i=0; i<n; i++) {
+                worker->total += batch->factors.v[first + i] * counts[i];
+                nodes += counts[i];
+        }
+        progress_add(worker->counter, n, nodes);
+
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      print_divide                                                    |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  One `fen,move,count' line per root move. The count is that of the
+ *  subtree times the repeat factor of the position, so that the lines
+ *  add up to the total. Lines from different workers don't mix, because
+ *  each is one call.
+ */
+static
+void print_divide(struct board *bd, int move, long long count)
+{
+        char fen[BOARD_MAX_FEN_STRING_SIZE];
+        char move_string[BOARD_MOVE_STRING_SIZE_MAX];
+
+        (void) board_fen_string(bd, fen);
+        (void) board_move_format_simple(move_string, move);
+        printf("%s,%s,%lld\n", fen, move_string, count);
+        fflush(stdout);
+}
+
+/*----------------------------------------------------------------------+
+ |      finish_job                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Add the count of a job to its line. The worker that finishes the
+ *  last job of a line stores the line's count in the database.
+ */
+static
+err_t finish_job(struct perft_worker *worker, int line, long long count)
+{
+        err_t err = OK;
+        struct perft_batch *batch = worker->batch;
+
+        worker->total += batch->factors.v[line] * count;
+
+        if (batch->roots.len > 0) {
+                struct perft_root *root = &batch->roots.v[line];
+                atomic_fetch_add(&root->count, count);
+                if (atomic_fetch_sub(&root->nr_jobs, 1) == 1) {
+                        err = pdb_append(database, &batch->keys.v[line],
+                                worker->depth, atomic_load(&root->count));
+                }
+        }
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      perft_worker_run                                                |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Take jobs from the batch until it is exhausted
+ */
+static
+err_t perft_worker_run(struct perft_worker *worker)
+{
+        err_t err = OK;
+        struct perft_batch *batch = worker->batch;
+        struct board *bd = worker->bd;
+
+        worker->line = -1;
+        progress_busy(worker->counter);
+
+        bool chunked = (batch->chunk > 0) && (worker->table == null);
+        int chunk = chunked ? batch->chunk : 1;
+
+        for (;;) {
+                int j = atomic_fetch_add_explicit(&batch->next_job, chunk, memory_order_relaxed);
+                if (j >= batch->jobs.len)
+                        break;
+
+                if (chunked) {
+                        // without splitting, job j is line j
+                        err = count_chunk(worker, j, min(chunk, batch->jobs.len - j));
+                        check(err);
+                        continue;
+                }
+
+                struct perft_job *job = &batch->jobs.v[j];
+
+                if (job->line != worker->line) {
+                        err = setup_line(bd, batch, job->line);
+                        check(err);
+                        worker->line = job->line;
+                }
+
+                long long count;
+                if (job->move_index < 0) {
+                        count = perft_root(worker, worker->depth);
+                        progress_add(worker->counter, 1, 0);
+                } else {
+                        union board_move moves[BOARD_MAX_MOVES];
+                        (void) board_generate_all_moves_unscored(bd, moves);
+                        board_make_move(bd, &moves[job->move_index]);
+                        count = perft_count(worker, worker->depth - 1);
+                        board_undo_move(bd);
+                        if (divide) {
+                                print_divide(bd, moves[job->move_index].bm.move,
+                                        batch->factors.v[job->line] * count);
+                        }
+
+                        // a split position counts as done with its last root move
+                        bool last = (j + 1 == batch->jobs.len) || (job[1].line != job->line);
+                        progress_add(worker->counter, last ? 1 : 0, count);
+                }
+
+                err = finish_job(worker, job->line, count);
+                check(err);
+        }
+
+cleanup:
+        progress_idle(worker->counter);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      perft_worker_main                                               |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Thread main: count the batches that the main thread hands over. After
+ *  an error the worker only keeps meeting the others at the barriers.
+ *
+ *  The worker makes its own board, so that the pages come from the
+ *  memory node of the thread that uses them. The thread stack is
+ *  touched first by the thread as well.
+ */
+static
+void perft_worker_main(void *data)
+{
+        struct perft_worker *worker = data;
+
+        worker->err = board_create(&worker->bd);
+        if (worker->err == OK) {
+                // plain counting doesn't need any keys
+                board_set_lazy_keys(worker->bd, worker->table == null);
+                board_set_max_depth(worker->bd, max(worker->depth, 1));
+        }
+
+        for (;;) {
+                waitBarrier(batch_start);
+                if (worker->batch == null)
+                        break;
+                if (worker->err == OK)
+                        worker->err = perft_worker_run(worker);
+                waitBarrier(batch_done);
+        }
+
+        board_stats_collect(&worker->stats);
+}
+
+/*----------------------------------------------------------------------+
+ |      stop_workers                                                    |
+ +----------------------------------------------------------------------*/
+
+static
+void stop_workers(struct perft_worker *workers, int nr_threads)
+{
+        for (int t=0; t<nr_threads; t++) {
+                workers[t].batch = null;
+        }
+        waitBarrier(batch_start);
+        for (int t=0; t<nr_threads; t++) {
+                joinThread(workers[t].thread);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      read_batch                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Read the next batch of input lines, and prepare the job list.
+ *  An empty batch means end of input.
+ */
+static
+err_t read_batch(
+        struct perft_batch *batch,
+        struct board *bd,
+        int depth,
+        int nr_threads,
+        xInput_t input)
+{
+        err_t err = OK;
+
+        batch->text.len = 0;
+        batch->offsets.len = 0;
+        batch->positions.len = 0;
+        batch->factors.len = 0;
+        batch->jobs.len = 0;
+        batch->keys.len = 0;
+        batch->roots.len = 0;
+        batch->snapshots.len = 0;
+        batch->known = 0;
+        batch->chunk = 0;
+        atomic_store(&batch->next_job, 0);
+
+        int nr_lines = 0;
+
+        while (input_format == record_binary && nr_lines < BATCH_MAX_LINES) {
+                struct record record;
+                if (!record_read_input(input, &record))
+                        break;
+                pushList(batch->positions, record.pos);
+                pushList(batch->factors, record.count);
+                nr_lines++;
+        }
+
+        while (input_format == record_csv && nr_lines < BATCH_MAX_LINES) {
+                const char *line;
+                int len = readSlice(input, &line);
+                if (len == 0)
+                        break;
+                long long factor;
+                int pos_len = record_split_csv(line, len, &factor);
+
+                pushList(batch->offsets, batch->text.len);
+                pushList(batch->factors, factor);
+                preparePushList(batch->text, pos_len + 1);
+                memcpy(&batch->text.v[batch->text.len], line, pos_len);
+                batch->text.v[batch->text.len + pos_len] = '\0';
+                batch->text.len += pos_len + 1;
+                nr_lines++;
+        }
+        progress_input_offset(progress, inputMapOffset(input));
+        progress_input_positions(progress, nr_lines);
+
+        bool split = (depth >= 2) && (nr_threads > 1) &&
+                (nr_lines < nr_threads * SPLIT_MIN_JOBS_PER_THREAD);
+        if (divide && depth >= 1)
+                split = true;
+        batch->split = split;
+
+        bool use_database = (database != null) && (depth >= PDB_MIN_DEPTH);
+
+        /*
+         *  Chunks of cheap lines, but still several for each thread
+         */
+        if (!split && !use_database && depth <= WORKER_CHUNK_MAX_DEPTH) {
+                int chunk = nr_lines / (nr_threads * SPLIT_MIN_JOBS_PER_THREAD);
+                batch->chunk = max(1, min(chunk, WORKER_CHUNK));
+        }
+        if (use_database) {
+                preparePushList(batch->keys, nr_lines);
+                preparePushList(batch->roots, nr_lines);
+        }
+
+        for (int line=0; line<nr_lines; line++) {
+                int nr_moves = 0;
+                if (split || (use_database && input_format == record_csv)) {
+                        err = setup_line(bd, batch, line);
+                        check(err);
+                }
+
+                /*
+                 *  Lines found in the database need no jobs. In divide
+                 *  mode they are counted anyway, for their root moves.
+                 */
+                if (use_database) {
+                        struct board_binary *key = &batch->keys.v[line];
+                        if (input_format == record_binary) {
+                                *key = batch->positions.v[line];
+                        } else {
+                                err = board_binary_record(bd, key);
+                                check(err);
+                        }
+                        batch->keys.len++;
+
+                        struct perft_root *root = &batch->roots.v[line];
+                        atomic_init(&root->count, 0);
+                        atomic_init(&root->nr_jobs, 0);
+                        batch->roots.len++;
+
+                        long long count;
+                        if (!divide && pdb_lookup(database, key, depth, &count)) {
+                                batch->known += batch->factors.v[line] * count;
+                                progress_add(progress_counter(progress, nr_threads), 1, 0);
+                                continue;
+                        }
+                }
+
+                /*
+                 *  The jobs of a split line go to many workers. Let them
+                 *  restore it instead of setting it up again each time.
+                 */
+                if (split) {
+                        union board_move moves[BOARD_MAX_MOVES];
+                        nr_moves = board_generate_all_moves_unscored(bd, moves);
+                        preparePushList(batch->snapshots, nr_lines);
+                        batch->snapshots.len = line + 1;
+                        board_snapshot(bd, &batch->snapshots.v[line]);
+                }
+                if (use_database) {
+                        atomic_init(&batch->roots.v[line].nr_jobs, max(nr_moves, 1));
+                }
+                if (nr_moves == 0) {
+                        struct perft_job job = { .line = line, .move_index = -1 };
+                        pushList(batch->jobs, job);
+                }
+                for (int i=0; i<nr_moves; i++) {
+                        struct perft_job job = { .line = line, .move_index = i };
+                        pushList(batch->jobs, job);
+                }
+        }
+
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      free_batch                                                      |
+ +----------------------------------------------------------------------*/
+
+static
+void free_batch(struct perft_batch *batch)
+{
+        freeList(batch->text);
+        freeList(batch->offsets);
+        freeList(batch->positions);
+        freeList(batch->factors);
+        freeList(batch->jobs);
+        freeList(batch->keys);
+        freeList(batch->roots);
+        freeList(batch->snapshots);
 }
 
 /*----------------------------------------------------------------------+
@@ -94,40 +746,203 @@ int main(int argc, char *argv[])
 {
         err_t err = OK;
         struct board *bd = null;
-        charList lineBuffer = emptyList;
+        struct perft_worker *workers = null;
+        struct ptable *table = null;
+        struct perft_batch batches[2] = {
+                { emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, 0, false, 0, 0 },
+                { emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, emptyList, 0, false, 0, 0 },
+        };
+        xInput_t input = null;
+        int nr_threads = 1;
+        bool workers_running = false;
+        bool print_stats = false;
+
+        /*
+         *  Usage: rmoves [-i csv|bin] [-j <threads>] [-h <size>] [-L] [-d] [-p <file>] [--stats] [--progress <seconds>] [-v <interval>] <depth>
+         *
+         *  The table size is in megabytes, or with a K, M or G suffix.
+         *  -L asks for huge pages for the table. -d divides: every
+         *  position is split into its root moves, and the count of each
+         *  is printed as soon as a worker finishes it. The total follows
+         *  at the end as usual. --stats prints the generator counters
+         *  to stderr, from a build with `make -B DEFINES=-DBOARD_STATS'.
+         *  -p keeps the count of every input position of at least depth
+         *  3 in a database file, and takes it from there the next time.
+         *  --progress reports to stderr at the interval: positions and
+         *  nodes counted so far, the node rate, the time to go when the
+         *  input is a file, and how busy each worker and then the reading
+         *  thread were. Compressed input is recognized and decompressed.
+         */
+        double progress_interval = 0.0;
+        long long table_size = 0;
+        bool huge_pages = false;
+        int i = 1;
+        for (; i<argc && argv[i][0] == '-'; i++) {
+                if (strcmp(argv[i], "-L") == 0) {
+                        huge_pages = true;
+                        continue;
+                }
+                if (strcmp(argv[i], "-d") == 0) {
+                        divide = true;
+                        continue;
+                }
+                if (strcmp(argv[i], "--stats") == 0) {
+#if !defined(BOARD_STATS)
+                        xRaise("Statistics need a build with -DBOARD_STATS");
+#endif
+                        print_stats = true;
+                        continue;
+                }
+                if (i+1 >= argc)
+                        xRaise("Invalid arguments");
+                if (strcmp(argv[i], "-i") == 0) {
+                        err = record_parse_format(argv[++i], &input_format);
+                        check(err);
+                } else if (strcmp(argv[i], "-j") == 0)
+                        nr_threads = atoi(argv[++i]);
+                else if (strcmp(argv[i], "-h") == 0) {
+                        err = parseSize(argv[++i], &table_size);
+                        check(err);
+                } else if (strcmp(argv[i], "-v") == 0)
+                        verify_interval = atoll(argv[++i]);
+                else if (strcmp(argv[i], "--progress") == 0)
+                        progress_interval = atof(argv[++i]);
+                else if (strcmp(argv[i], "-p") == 0) {
+                        if (database != null)
+                                xRaise("Invalid arguments");
+                        err = pdb_open(&database, argv[++i]);
+                        check(err);
+                        if (!pdb_appending(database))
+                                fprintf(stderr, "%s: Database %s is read only\n", argv[0], argv[i]);
+                } else
+                        xRaise("Invalid arguments");
+        }
 
-        if (argc != 2)
+        if (i != argc-1)
                 xRaise("Invalid arguments");
 
-        int depth = atoi(argv[1]);
+        int depth = atoi(argv[i]);
+        if (depth < 0 || depth > PTABLE_MAX_DEPTH || depth > PDB_MAX_DEPTH)
+                xRaise("Invalid depth");
+
+        if (nr_threads < 1)
+                xRaise("Invalid number of threads");
 
         err = board_create(&bd);
         check(err);
+        board_set_max_depth(bd, 1); // for splitting into root moves
+        board_set_lazy_keys(bd, true);
+
+        if (table_size > 0) {
+                // a shared table is best spread over all memory nodes
+                int memory_flags = (huge_pages ? memoryHugePages : 0) |
+                        (nr_threads > 1 ? memoryInterleaved : 0);
+                err = ptable_create(&table, table_size, memory_flags);
+                check(err);
+        }
+
+        /*
+         *  Each worker makes its own board. They all share the table.
+         */
+        workers = calloc(nr_threads, sizeof(*workers));
+        if (workers == null) xRaise(ERR_NO_MEMORY);
+
+        for (int t=0; t<nr_threads; t++) {
+                workers[t].depth = depth;
+                workers[t].table = table;
+        }
+
+        err = progress_create(&progress, argv[0], nr_threads + 1, progress_interval, stdin);
+        check(err);
+        for (int t=0; t<nr_threads; t++) {
+                workers[t].counter = progress_counter(progress, t);
+        }
+        struct progress_counter *reader = progress_counter(progress, nr_threads);
+
+        batch_start = createBarrier(nr_threads + 1);
+        batch_done = createBarrier(nr_threads + 1);
+        for (int t=0; t<nr_threads; t++) {
+                workers[t].thread = createThread(perft_worker_main, &workers[t]);
+        }
+        workers_running = true;
+
+        err = compress_open_input(stdin, &input);
+        check(err);
+
+        /*
+         *  Count each batch while reading the next
+         */
+        struct perft_batch *batch = &batches[0];
+        struct perft_batch *next_batch = &batches[1];
+
+        progress_busy(reader);
+        err = read_batch(batch, bd, depth, nr_threads, input);
+        progress_idle(reader);
+        check(err);
 
         long long total = 0;
 
-        while (readLine(stdin, &lineBuffer) != 0) {
-                //fputs(lineBuffer.v, stdout);
-                long long factor = 0;
-                char *s = strchr(lineBuffer.v, ',');
-                if (s == null)
-                        s = strchr(lineBuffer.v, '\n');
-                else
-                        factor = atoll(s+1);
-                if (s != null)
-                        *s = '\0';
-                err = board_setup_raw(bd, lineBuffer.v);
+        while (batch->factors.len > 0) {
+                for (int t=0; t<nr_threads; t++) {
+                        workers[t].batch = batch;
+                }
+                waitBarrier(batch_start);
+
+                progress_busy(reader);
+                err_t read_err = read_batch(next_batch, bd, depth, nr_threads, input);
+                progress_idle(reader);
+
+                waitBarrier(batch_done);
+                for (int t=0; t<nr_threads; t++) {
+                        if (err == OK)
+                                err = workers[t].err;
+                }
+                if (err == OK)
+                        err = read_err;
                 check(err);
-                long long result;
-                board_perft(bd, depth, &result);
-                total += factor * result;
+
+                total += batch->known;
+
+                struct perft_batch *swap = batch;
+                batch = next_batch;
+                next_batch = swap;
+        }
+
+        stop_workers(workers, nr_threads);
+        workers_running = false;
+
+        struct board_stats stats = { .exchange_hits = 0 };
+        for (int t=0; t<nr_threads; t++) {
+                total += workers[t].total;
+                board_stats_add(&stats, &workers[t].stats);
         }
 
+        progress_destroy(progress); // the final report goes before the total
+        progress = null;
+
         printf("%lld\n", total);
 
+        if (print_stats)
+                board_stats_print(&stats);
+
 cleanup:
+        if (workers_running)
+                stop_workers(workers, nr_threads);
+        destroyBarrier(batch_start);
+        destroyBarrier(batch_done);
+        if (workers != null) {
+                for (int t=0; t<nr_threads; t++) {
+                        board_destroy(workers[t].bd);
+                }
+                free(workers);
+        }
+        progress_destroy(progress);
+        ptable_destroy(table);
+        pdb_close(database);
         board_destroy(bd);
-        freeList(lineBuffer);
+        free_batch(&batches[0]);
+        free_batch(&batches[1]);
+        closeInput(input);
         return errExitMain(err);
 }
 
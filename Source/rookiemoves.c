@@ -0,0 +1,249 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      rookiemoves.c -- Python extension for bulk position expansion   |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Usage from Python 3, after `make python':
+ *
+ *      import rookiemoves
+ *      children = rookiemoves.expand(b'<fen>,<count>\n...', depth=1)
+ *
+ *  expand() takes a bytes-like buffer of `fen,count' lines, and gives
+ *  the `fen,count' lines of all positions after <depth> more ply, in
+ *  the position order of the input. The counts carry over, as with
+ *  expand.c. The work runs without the GIL, so a thread pool that
+ *  feeds it blocks of lines keeps all cores busy.
+ *
+ *  moves() gives the positions after one move of a single FEN.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cplus.h"
+
+#include "board.h"
+#include "records.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+#define EXPAND_MAX_DEPTH 16
+
+struct expansion {
+        struct board *bd;
+        charList output;
+        char count[24];         // `,<count>\n' of the current line
+        int count_len;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+static
+void expand_node(struct expansion *ex, int depth)
+{
+        struct board *bd = ex->bd;
+
+        if (depth == 0) {
+                char fen[BOARD_MAX_FEN_STRING_SIZE];
+                (void) board_fen_string(bd, fen);
+                int len = strlen(fen);
+                preparePushList(ex->output, len + ex->count_len);
+                memcpy(&ex->output.v[ex->output.len], fen, len);
+                memcpy(&ex->output.v[ex->output.len + len], ex->count, ex->count_len);
+                ex->output.len += len + ex->count_len;
+                return;
+        }
+
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        for (int i=0; i<nr_moves; i++) {
+                board_make_move(bd, &moves[i]);
+                expand_node(ex, depth-1);
+                board_undo_move(bd);
+        }
+}
+
+/*
+ *  Expand all lines of the buffer. On error, *line_p gives the line number.
+ */
+static
+err_t expand_buffer(
+        struct expansion *ex,
+        const char *data,
+        Py_ssize_t size,
+        int depth,
+        long long *line_p)
+{
+        err_t err = OK;
+        charList fen = emptyList;
+        long long line = 0;
+
+        for (Py_ssize_t i=0; i<size; ) {
+                const char *start = &data[i];
+                const char *end = memchr(start, '\n', size - i);
+                int len = (end != null) ? (int) (end - start) : (int) (size - i);
+                i += len + 1;
+                line++;
+
+                long long factor;
+                int pos_len = record_split_csv(start, len, &factor);
+                if (pos_len == 0)
+                        continue;
+                ex->count_len = sprintf(ex->count, ",%lld\n", factor);
+
+                fen.len = 0;
+                preparePushList(fen, pos_len + 1);
+                memcpy(fen.v, start, pos_len);
+                fen.v[pos_len] = '\0';
+
+                err = board_setup_raw(ex->bd, fen.v);
+                check(err);
+
+                expand_node(ex, depth);
+        }
+
+cleanup:
+        *line_p = line;
+        freeList(fen);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      Python methods                                                  |
+ +----------------------------------------------------------------------*/
+
+static
+PyObject *rookiemoves_expand(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+        static char *keywords[] = { "data", "depth", null };
+        Py_buffer buffer;
+        int depth = 1;
+        unused(self);
+
+        if (!PyArg_ParseTupleAndKeywords(args, kwargs, "y*|i", keywords, &buffer, &depth))
+                return null;
+
+        if (depth < 0 || depth > EXPAND_MAX_DEPTH) {
+                PyBuffer_Release(&buffer);
+                PyErr_SetString(PyExc_ValueError, "Invalid depth");
+                return null;
+        }
+
+        struct expansion ex = { .bd = null, .output = emptyList, .count_len = 0 };
+        long long line = 0;
+        err_t err;
+
+        Py_BEGIN_ALLOW_THREADS
+        err = board_create(&ex.bd);
+        if (err == OK) {
+                board_set_lazy_keys(ex.bd, true);
+                board_set_max_depth(ex.bd, max(depth, 1));
+                err = expand_buffer(&ex, buffer.buf, buffer.len, depth, &line);
+        }
+        board_destroy(ex.bd);
+        Py_END_ALLOW_THREADS
+
+        PyBuffer_Release(&buffer);
+
+        PyObject *result = null;
+        if (err == OK) {
+                result = PyBytes_FromStringAndSize(ex.output.v, ex.output.len);
+        } else {
+                PyErr_Format(PyExc_ValueError, "%s (line %lld)", err->format, line);
+        }
+        freeList(ex.output);
+        return result;
+}
+
+static
+PyObject *rookiemoves_moves(PyObject *self, PyObject *args)
+{
+        const char *fen;
+        unused(self);
+
+        if (!PyArg_ParseTuple(args, "s", &fen))
+                return null;
+
+        struct board *bd = null;
+        err_t err = board_create(&bd);
+        if (err == OK)
+                err = board_setup_raw(bd, fen);
+        if (err != OK) {
+                board_destroy(bd);
+                PyErr_SetString(PyExc_ValueError, err->format);
+                return null;
+        }
+
+        union board_move moves[BOARD_MAX_MOVES];
+        int nr_moves = board_generate_all_moves_unscored(bd, moves);
+
+        PyObject *result = PyList_New(nr_moves);
+        for (int i=0; i<nr_moves && result != null; i++) {
+                char new_fen[BOARD_MAX_FEN_STRING_SIZE];
+                board_make_move(bd, &moves[i]);
+                (void) board_fen_string(bd, new_fen);
+                board_undo_move(bd);
+
+                PyObject *item = PyUnicode_FromString(new_fen);
+                if (item == null) {
+                        Py_CLEAR(result);
+                        break;
+                }
+                PyList_SET_ITEM(result, i, item);
+        }
+
+        board_destroy(bd);
+        return result;
+}
+
+/*----------------------------------------------------------------------+
+ |      Module definition                                               |
+ +----------------------------------------------------------------------*/
+
+static PyMethodDef rookiemoves_methods[] = {
+        {
+                "expand", (PyCFunction)(void(*)(void)) rookiemoves_expand, METH_VARARGS | METH_KEYWORDS,
+                "expand(data, depth=1) -> bytes\n"
+                "Expand a buffer of `fen,count' lines by depth ply, without the GIL"
+        },
+        {
+                "moves", rookiemoves_moves, METH_VARARGS,
+                "moves(fen) -> list\n"
+                "The positions after each legal move"
+        },
+        { null, null, 0, null }
+};
+
+static struct PyModuleDef rookiemoves_module = {
+        PyModuleDef_HEAD_INIT,
+        "rookiemoves",
+        "Rookie move generator for bulk position expansion",
+        -1,
+        rookiemoves_methods,
+        null, null, null, null
+};
+
+PyMODINIT_FUNC PyInit_rookiemoves(void)
+{
+        return PyModule_Create(&rookiemoves_module);
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,378 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      uniq.c -- Merge identical positions and sum their counts        |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      Includes                                                        |
+ +----------------------------------------------------------------------*/
+
+#define _DEFAULT_SOURCE // for mkstemp and fdopen
+
+/*
+ *  C standard includes
+ */
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__unix) || (defined(__APPLE__) && defined(__MACH__))
+ #include <unistd.h>
+ #define POSIX
+#endif
+
+/*
+ *  Base include
+ */
+#include "cplus.h"
+
+/*
+ *  Own interface include
+ */
+#include "board.h"
+#include "records.h"
+#include "uniq.h"
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Free slots are marked with an impossible side to move
+ */
+#define UNIQ_FREE 0xff
+
+/*
+ *  Spill when the map is this full (percent)
+ */
+#define UNIQ_MAX_LOAD 75
+
+struct uniq {
+        struct record *slots;
+        long long mask;
+        long long nr_used;
+        const char *temp_dir;
+        List(FILE*) runs;
+};
+
+/*
+ *  One sorted run during the final merge
+ */
+struct uniq_run {
+        FILE *fp;
+        struct record head;
+};
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------+
+ |      clear_slots                                                     |
+ +----------------------------------------------------------------------*/
+
+static
+void clear_slots(struct uniq *uniq)
+{
+        for (long long i=0; i<=uniq->mask; i++) {
+                uniq->slots[i].pos.side_to_move = UNIQ_FREE;
+        }
+        uniq->nr_used = 0;
+}
+
+/*----------------------------------------------------------------------+
+ |      uniq_create                                                     |
+ +----------------------------------------------------------------------*/
+
+err_t uniq_create(struct uniq **uniq_p, long long memory_size, const char *temp_dir)
+{
+        err_t err = OK;
+        struct uniq *uniq = null;
+
+        long long nr_slots = 1024;
+        while (2 * nr_slots * (long long) sizeof(struct record) <= memory_size) {
+                nr_slots *= 2;
+        }
+
+        uniq = calloc(1, sizeof(*uniq));
+        if (uniq == null) xRaise(ERR_NO_MEMORY);
+
+        uniq->slots = malloc(nr_slots * sizeof(struct record));
+        if (uniq->slots == null) xRaise(ERR_NO_MEMORY);
+
+        uniq->mask = nr_slots - 1;
+        uniq->temp_dir = temp_dir;
+        clear_slots(uniq);
+
+        *uniq_p = uniq;
+        uniq = null;
+cleanup:
+        uniq_destroy(uniq);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      uniq_destroy                                                    |
+ +----------------------------------------------------------------------*/
+
+void uniq_destroy(struct uniq *uniq)
+{
+        if (uniq != null) {
+                for (int i=0; i<uniq->runs.len; i++) {
+                        fclose(uniq->runs.v[i]);
+                }
+                freeList(uniq->runs);
+                free(uniq->slots);
+                free(uniq);
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      sort_slots                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Pack the used slots at the front and sort them
+ */
+static
+void sort_slots(struct uniq *uniq)
+{
+        long long n = 0;
+        for (long long i=0; i<=uniq->mask; i++) {
+                if (uniq->slots[i].pos.side_to_move != UNIQ_FREE) {
+                        uniq->slots[n++] = uniq->slots[i];
+                }
+        }
+        assert(n == uniq->nr_used);
+
+        qsort(uniq->slots, n, sizeof(uniq->slots[0]), record_compare);
+}
+
+/*----------------------------------------------------------------------+
+ |      open_temp_file                                                  |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Anonymous temporary file: it disappears when closed
+ */
+static
+err_t open_temp_file(const char *temp_dir, FILE **fp_p)
+{
+        err_t err = OK;
+        FILE *fp = null;
+
+#if defined(POSIX)
+        if (temp_dir != null) {
+                charList path = emptyList;
+                listPrintf(&path, "%s/uniq.XXXXXX", temp_dir);
+                int fd = mkstemp(path.v);
+                if (fd != -1) {
+                        (void) unlink(path.v);
+                        fp = fdopen(fd, "w+b");
+                        if (fp == null)
+                                (void) close(fd);
+                }
+                freeList(path);
+        } else
+#else
+        unused(temp_dir);
+#endif
+        fp = tmpfile();
+
+        if (fp == null)
+                xRaise("Cannot create temporary file");
+
+        *fp_p = fp;
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      spill                                                           |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Write the map contents as one sorted run
+ */
+static
+err_t spill(struct uniq *uniq)
+{
+        err_t err = OK;
+        FILE *fp = null;
+
+        err = open_temp_file(uniq->temp_dir, &fp);
+        check(err);
+        pushList(uniq->runs, fp);
+
+        sort_slots(uniq);
+        for (long long i=0; i<uniq->nr_used; i++) {
+                record_write(fp, &uniq->slots[i]);
+        }
+        if (fflush(fp) != 0)
+                xRaise("Cannot write temporary file");
+
+        clear_slots(uniq);
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      uniq_add                                                        |
+ +----------------------------------------------------------------------*/
+
+err_t uniq_add(struct uniq *uniq, unsigned long long hash, const struct record *record)
+{
+        err_t err = OK;
+
+        /*
+         *  Linear probing
+         */
+        long long i = hash & uniq->mask;
+        for (;;) {
+                struct record *slot = &uniq->slots[i];
+
+                if (slot->pos.side_to_move == UNIQ_FREE) {
+                        *slot = *record;
+                        uniq->nr_used++;
+                        break;
+                }
+                if (memcmp(&slot->pos, &record->pos, BOARD_BINARY_SIZE) == 0) {
+                        slot->count += record->count;
+                        break;
+                }
+                i = (i + 1) & uniq->mask;
+        }
+
+        if (uniq->nr_used * 100 > (uniq->mask + 1) * UNIQ_MAX_LOAD) {
+                err = spill(uniq);
+                check(err);
+        }
+cleanup:
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |      sift_down                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Min-heap of runs, ordered by their head record
+ */
+static
+void sift_down(struct uniq_run *heap, int n, int i)
+{
+        for (;;) {
+                int child = 2 * i + 1;
+                if (child >= n)
+                        break;
+                if ((child + 1 < n) &&
+                    (record_compare(&heap[child+1].head, &heap[child].head) < 0)
+                ) {
+                        child++;
+                }
+                if (record_compare(&heap[child].head, &heap[i].head) >= 0)
+                        break;
+                struct uniq_run swap = heap[i];
+                heap[i] = heap[child];
+                heap[child] = swap;
+                i = child;
+        }
+}
+
+/*----------------------------------------------------------------------+
+ |      next_head                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Advance the top run, dropping it from the heap when exhausted
+ */
+static
+void next_head(struct uniq_run *heap, int *n_p)
+{
+        if (!record_read(heap[0].fp, &heap[0].head)) {
+                heap[0] = heap[--*n_p];
+        }
+        sift_down(heap, *n_p, 0);
+}
+
+/*----------------------------------------------------------------------+
+ |      uniq_finish                                                     |
+ +----------------------------------------------------------------------*/
+
+err_t uniq_finish(struct uniq *uniq, uniq_output_fn *output, void *data)
+{
+        err_t err = OK;
+        struct uniq_run *heap = null;
+
+        /*
+         *  Everything fits in memory: no need to go through the disk
+         */
+        if (uniq->runs.len == 0) {
+                sort_slots(uniq);
+                for (long long i=0; i<uniq->nr_used; i++) {
+                        if (uniq->slots[i].count > 0LL) {
+                                err = output(data, &uniq->slots[i]);
+                                check(err);
+                        }
+                }
+                clear_slots(uniq);
+                xReturn;
+        }
+
+        err = spill(uniq);
+        check(err);
+
+        /*
+         *  K-way merge of the runs
+         */
+        heap = calloc(uniq->runs.len, sizeof(*heap));
+        if (heap == null) xRaise(ERR_NO_MEMORY);
+
+        int n = 0;
+        for (int i=0; i<uniq->runs.len; i++) {
+                FILE *fp = uniq->runs.v[i];
+                rewind(fp);
+                if (record_read(fp, &heap[n].head)) {
+                        heap[n++].fp = fp;
+                }
+        }
+        for (int i=n/2-1; i>=0; i--) {
+                sift_down(heap, n, i);
+        }
+
+        while (n > 0) {
+                struct record record = heap[0].head;
+                next_head(heap, &n);
+
+                while (n > 0 && record_compare(&heap[0].head, &record) == 0) {
+                        record.count += heap[0].head.count;
+                        next_head(heap, &n);
+                }
+
+                if (record.count > 0LL) {
+                        err = output(data, &record);
+                        check(err);
+                }
+        }
+
+        for (int i=0; i<uniq->runs.len; i++) {
+                fclose(uniq->runs.v[i]);
+        }
+        uniq->runs.len = 0;
+
+done:
+cleanup:
+        free(heap);
+        return err;
+}
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
@@ -0,0 +1,68 @@
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ |      uniq.h -- Merge identical positions and sum their counts        |
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Description:
+ *      In-process replacement for `sort | combine'.
+ *
+ *      Positions are collected in a hash map keyed on the binary record,
+ *      summing counts of repeated positions as they come in. When the map
+ *      reaches its memory budget, its contents are sorted and spilled to
+ *      a temporary file as one run. At the end all runs are merged, and
+ *      each position comes out once with its total count. Positions with
+ *      a total count of zero or less are dropped, as `combine' does.
+ *
+ *      The output has the same set of lines as `sort | combine', but not
+ *      in the same order: it is sorted on the binary record, not on the
+ *      FEN text. Pipe it through `sort' where the text order matters.
+ */
+
+/*----------------------------------------------------------------------+
+ |      Synopsis                                                        |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  #include <stdio.h>
+ *  #include "cplus.h"
+ *  #include "board.h"
+ *  #include "records.h"
+ *  #include "uniq.h"
+ */
+
+/*----------------------------------------------------------------------+
+ |      Definitions                                                     |
+ +----------------------------------------------------------------------*/
+
+struct uniq;
+
+typedef err_t uniq_output_fn(void *data, const struct record *record);
+
+/*----------------------------------------------------------------------+
+ |      Functions                                                       |
+ +----------------------------------------------------------------------*/
+
+/*
+ *  Temporary files go in `temp_dir', or the system default if null
+ */
+err_t uniq_create(struct uniq **uniq_p, long long memory_size, const char *temp_dir);
+void uniq_destroy(struct uniq *uniq);
+
+/*
+ *  Add a position. The hash can be any function of the position.
+ */
+err_t uniq_add(struct uniq *uniq, unsigned long long hash, const struct record *record);
+
+/*
+ *  Pass all positions in binary record order to `output'. The map is
+ *  empty after.
+ */
+err_t uniq_finish(struct uniq *uniq, uniq_output_fn *output, void *data);
+
+/*----------------------------------------------------------------------+
+ |                                                                      |
+ +----------------------------------------------------------------------*/
+
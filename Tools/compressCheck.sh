@@ -0,0 +1,71 @@
+#!/bin/sh -e
+#
+# compressCheck.sh -- Round trip of the compressed formats through the tools
+#
+# Usage: compressCheck.sh <method> ...
+#
+# For each method (bz2, zst or lz4), compresses the positions after 3 ply
+# with `expand -z', and checks that `expand 0', `rmoves' and `combine'
+# read them back the same as the plain text. This includes concatenated
+# streams, files from the command line compressor when it is installed,
+# and truncated input, which must fail. The methods other than bz2 need
+# a build with their libraries (see the Makefile). Run from the top
+# directory after `make'.
+#
+
+if [ $# -lt 1 ]
+then
+        echo "$0: Argument error" 1>&2
+        exit 1
+fi
+
+dir=`mktemp -d`
+trap 'rm -rf "$dir"' EXIT
+
+echo 'rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1,1' |
+./expand 3 | ./combine > $dir/plain.csv
+count=`./rmoves 1 < $dir/plain.csv`
+
+fail() {
+        echo "$0: $1: $2" 1>&2
+        exit 1
+}
+
+for method in "$@"
+do
+        case $method in
+        bz2) cli=bzip2 ;;
+        zst) cli=zstd ;;
+        lz4) cli=lz4 ;;
+        *) fail $method "Unknown method" ;;
+        esac
+
+        file=$dir/positions.$method
+        ./expand -z $method 0 < $dir/plain.csv > $file
+
+        ./expand 0 < $file | cmp -s - $dir/plain.csv || fail $method "expand 0 differs"
+        ./combine < $file | cmp -s - $dir/plain.csv || fail $method "combine differs"
+        [ "`./rmoves 1 < $file`" = $count ] || fail $method "rmoves count differs"
+
+        ./expand -z $method -o bin 0 < $dir/plain.csv > $file.bin
+        ./expand -i bin 0 < $file.bin | cmp -s - $dir/plain.csv || fail $method "binary records differ"
+
+        cat $file $file > $file.cat
+        cat $dir/plain.csv $dir/plain.csv > $dir/twice.csv
+        ./expand 0 < $file.cat | cmp -s - $dir/twice.csv || fail $method "concatenated streams differ"
+
+        if command -v $cli > /dev/null
+        then
+                $cli -c < $dir/plain.csv > $file.cli
+                ./expand 0 < $file.cli | cmp -s - $dir/plain.csv || fail $method "$cli output differs"
+        fi
+
+        size=`wc -c < $file`
+        head -c `expr $size / 2` $file > $file.cut
+        if ./expand 0 < $file.cut > /dev/null 2>&1
+        then
+                fail $method "truncated input accepted"
+        fi
+
+        echo "$method: ok"
+done
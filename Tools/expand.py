@@ -1,7 +1,41 @@
-import chessmoves
+#
+# expand.py -- Expand `fen,count' lines by one ply, on all cores
+#
+# Needs Python 3 and the extension from `make python'. Blocks of input
+# lines go to rookiemoves.expand on a thread pool, which runs without
+# the GIL. The output keeps the order of the input.
+#
+
+import collections
+import concurrent.futures
+import os
 import sys
 
-for line in sys.stdin:
-        pos, count = line.split(',')
-        for newPos in chessmoves.moves(pos).values():
-                print '%s,%s' % (newPos, count),
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+import rookiemoves
+
+blockSize = 1 << 20
+
+def blocks(fp):
+        rest = b''
+        while True:
+                data = fp.read(blockSize)
+                if not data:
+                        break
+                data = rest + data
+                cut = data.rfind(b'\n') + 1
+                rest = data[cut:]
+                if cut > 0:
+                        yield data[:cut]
+        if rest:
+                yield rest
+
+nrThreads = os.cpu_count() or 1
+with concurrent.futures.ThreadPoolExecutor(nrThreads) as pool:
+        pending = collections.deque()
+        for block in blocks(sys.stdin.buffer):
+                pending.append(pool.submit(rookiemoves.expand, block))
+                if len(pending) > 2 * nrThreads:
+                        sys.stdout.buffer.write(pending.popleft().result())
+        while pending:
+                sys.stdout.buffer.write(pending.popleft().result())
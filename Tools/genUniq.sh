@@ -34,9 +34,9 @@ do
                 mkdir -p Temp
 
                 lbzip2 -c -d ply.$M.csv.bz2 |
-                python Tools/expand.py |
+                python3 Tools/expand.py |
                 LC_ALL=C $sort -TTemp --compress-program=$tempZip --buffer-size=$bzipBuffer |
-                python Tools/combine.py |
+                ./combine |
                 lbzip2 -1 -c > ply.$N.csv.tmp
 
                 mv ply.$N.csv.tmp ply.$N.csv.bz2
@@ -0,0 +1,48 @@
+#!/bin/sh -e
+#
+# perftUnit.sh -- Count one work unit for perftUnits.sh
+#
+# Usage: perftUnit.sh <node> <depth> <unitFile> [rmoves options]
+#
+# Claims the unit for the node first, and skips it when another node
+# was first. Prints one journal line `unit,count,seconds,finished' on
+# success and nothing on failure, so that a failed unit is simply not
+# journaled. Its claim is then released again for a retry.
+#
+
+if [ $# -lt 3 ]
+then
+        echo "$0: Argument error" 1>&2
+        exit 1
+fi
+node=$1
+depth=$2
+unit=$3
+shift 3
+
+mv=mv
+if [ `uname -s` = "Darwin" ]
+then
+        mv=gmv # For -T
+fi
+
+# The claim appears with its owner in one rename, which fails when
+# another node's claim is already there
+claim=`dirname $unit`/claim.`basename $unit`
+mkdir $claim.$node.$$
+touch $claim.$node.$$/$node
+if ! $mv -T $claim.$node.$$ $claim 2> /dev/null
+then
+        rm -rf $claim.$node.$$
+        exit 0
+fi
+
+start=`date +%s`
+if ! count=`./rmoves "$@" $depth < "$unit"`
+then
+        rm -rf $claim
+        exit 1
+fi
+finished=`date +%s`
+
+echo "`basename $unit`,$count,`expr $finished - $start`,$finished"
@@ -0,0 +1,148 @@
+#!/bin/sh -e
+#
+# perftUnits.sh -- Restartable perft over a position file in work units
+#
+# Usage: perftUnits.sh [-s | -r <node>] <positionFile> <depth> [<linesPerUnit>]
+#
+# The position file (`fen,count' lines, optionally compressed) is split
+# once into numbered unit files in Units.<name>.<depth>.<linesPerUnit>/.
+# The file `params' there records the input and its size, the depth and
+# the unit size, and a run with other values for the same directory is
+# refused. Each completed unit appends `unit,count,seconds,finished' to
+# the journal of the node that ran it. Running the same command again
+# skips the journaled units, so a crashed or interrupted run resumes
+# where it stopped. At the end the units done, the total count and the
+# throughput are reported. With -s it only reports.
+#
+# For many nodes, start the same command on each of them, in the same
+# directory on a shared file system. A node claims a unit by renaming a
+# directory to claim.<unit>/, which is atomic also over NFS, and writes
+# only its own journal.<node>. A node that restarts first releases the
+# claims it left unfinished. With -r, the claims of a node that is gone
+# for good are released, so that the others can take its units.
+#
+# Environment:
+#       NODE    Name of this node (default: hostname)
+#       JOBS    Units in parallel on this node (default: number of cores)
+#       RMOVES  Extra rmoves options, for example "-j 4 -h 1G"
+#
+
+status()
+{
+        nrUnits=`ls $dir | grep -c '^unit\.' || true`
+        cat $dir/journal.* < /dev/null 2> /dev/null |
+        sort -t, -k1,1 -u |
+        ${PYTHON:-python3} -c '
+import sys
+nrUnits = int(sys.argv[1])
+done, total, seconds, first, last = 0, 0, 0, None, None
+for line in sys.stdin:
+        unit, count, secs, finished = line.strip().split(",")
+        done += 1
+        total += int(count)
+        seconds += int(secs)
+        begin = int(finished) - int(secs)
+        first = begin if first is None else min(first, begin)
+        last = int(finished) if last is None else max(last, int(finished))
+print("units:   %d of %d" % (done, nrUnits))
+print("count:   %d%s" % (total, "" if done == nrUnits else " (incomplete)"))
+if done > 0:
+        wall = max(last - first, 1)
+        print("seconds: %d in units, %d wall" % (seconds, wall))
+        print("rate:    %.4g nodes/s wall, %.4g nodes/s per unit" %
+                (total / wall, total / max(seconds, 1)))
+' $nrUnits
+}
+
+# Remove the claims of a node that have no journal line
+release()
+{
+        cat $dir/journal.* < /dev/null 2> /dev/null | cut -d, -f1 | sort -u > $dir/done.$node.tmp
+        for claim in `cd $dir && ls -d claim.unit.* 2> /dev/null`
+        do
+                unit=${claim#claim.}
+                if [ -f $dir/$claim/$1 ] && ! grep -qx $unit $dir/done.$node.tmp
+                then
+                        rm -rf $dir/$claim
+                fi
+        done
+        rm -f $dir/done.$node.tmp
+}
+
+mode=run
+case "$1" in
+-s)     mode=status; shift ;;
+-r)     mode=release; releaseNode=$2; shift 2 ;;
+esac
+
+if [ $# -lt 2 ] || [ $# -gt 3 ] || [ -z "$1" ]
+then
+        echo "$0: Argument error" 1>&2
+        exit 1
+fi
+positions=$1
+depth=$2
+linesPerUnit=${3:-1000}
+dir=Units.`basename $positions`.$depth.$linesPerUnit
+node=${NODE:-`hostname`}
+
+mv=mv
+if [ `uname -s` = "Darwin" ]
+then
+        mv=gmv # For -T
+fi
+jobs=${JOBS:-`getconf _NPROCESSORS_ONLN`}
+
+params="`basename $positions`,`wc -c < $positions`,$depth,$linesPerUnit"
+
+# Split only once: the unit files must stay the same on resume. Of nodes
+# that start together, the first to rename its split directory wins.
+if [ ! -d $dir ] && [ $mode = run ]
+then
+        rm -rf $dir.$node.tmp
+        mkdir $dir.$node.tmp
+        ./expand 0 < $positions | (cd $dir.$node.tmp && split -a 6 -l $linesPerUnit - unit.)
+        echo "$params" > $dir.$node.tmp/params
+        $mv -T $dir.$node.tmp $dir 2> /dev/null || rm -rf $dir.$node.tmp
+fi
+
+if [ ! -f $dir/params ]
+then
+        echo "$0: No units in $dir" 1>&2
+        exit 1
+fi
+if [ "`cat $dir/params`" != "$params" ]
+then
+        echo "$0: $dir was made for `cat $dir/params`, not $params" 1>&2
+        exit 1
+fi
+
+case $mode in
+status)
+        status
+        exit ;;
+release)
+        release $releaseNode
+        exit ;;
+esac
+
+release $node
+
+# The units that no node has claimed yet, in order. perftUnit.sh claims
+# each again just before it runs, because other nodes may be faster.
+(cd $dir && ls) | sed -n 's/^claim\.//p' | sort > $dir/claimed.$node.tmp
+ls $dir | grep '^unit\.' | sort | comm -23 - $dir/claimed.$node.tmp | sed "s|^|$dir/|" > $dir/todo.$node.tmp
+echo "$node: `wc -l < $dir/todo.$node.tmp` units to go" 1>&2
+
+# The node's journal has one writer: each unit's line arrives here when done
+failed=
+xargs -P $jobs -I{} Tools/perftUnit.sh $node $depth {} $RMOVES < $dir/todo.$node.tmp >> $dir/journal.$node ||
+        failed=yes
+
+rm -f $dir/claimed.$node.tmp $dir/todo.$node.tmp
+status
+if [ -n "$failed" ]
+then
+        echo "Some units failed, run again to retry them" 1>&2
+        exit 1
+fi